@@ -84,6 +84,7 @@ public:
   adc_channel_t channel;
   ObjMsgSample mode;
   int hysteresis;
+  uint16_t nameId; ///< Interned name, for producing data
 
 protected:
   // Raw variables
@@ -121,6 +122,9 @@ public:
 
     anyChangeEvents = false;
     this->sampleIntervalMs = sampleIntervalMs;
+    // Only the latest analog sample matters
+    conflate = true;
+    overflow = DROP_OLDEST;
   }
 
   /// Add 'channel' as 'name', configured with 'atten', 'bitwidth', and 'maxCounts'
@@ -138,6 +142,11 @@ public:
     adc_atten_t atten, adc_bitwidth_t bitwidth,
     int16_t maxCounts, int32_t min, int32_t max)
   {
+    if (ObjMsgData::InternName(name) == OBJMSG_NO_NAME)
+    {
+      ESP_LOGE(TAG.c_str(), "Add(%s): name table full", name.c_str());
+      return NULL;
+    }
     adc_oneshot_chan_cfg_t config = {
         .atten = atten,
         .bitwidth = bitwidth};
@@ -146,6 +155,7 @@ public:
 
     channels[name] = new AdcChannel(channel, mode, maxCounts, min, max);
     AdcChannel *tmp = channels[name];
+    tmp->nameId = ObjMsgData::InternName(name);
 
     if (mode == CHANGE_EVENT)
     {
@@ -224,8 +234,8 @@ protected:
           if (abs(value - js->GetValue()) > js->hysteresis)
           {
             ObjMsgDataRef data = ObjMsgAdcData::Create(
-              ep->origin_id, it->first.c_str(), js->GetValue());
-            ep->Produce(data);
+              ep->origin_id, js->nameId, js->GetValue());
+            ep->Produce(std::move(data));
           }
         }
       }
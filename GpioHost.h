@@ -4,6 +4,8 @@
 
 #include "ObjMsg.h"
 
+#define GPIO_ISR_POOL_DEPTH 8 ///< Preallocated data per CHANGE_EVENT port, for isr_handler
+
 enum GpioFlags ///< GPIO flags (_GF)
 {
   DEFAULT_GF = 0,
@@ -20,6 +22,7 @@ inline GpioFlags operator|(GpioFlags a, GpioFlags b)
 }
 
 typedef ObjMsgDataInt ObjMsgGpioData;
+typedef ObjMsgDataPool<ObjMsgGpioData> ObjMsgGpioPool;
 class GpioHost;
 
 /// A GPIO Port hosted by GpioHost
@@ -43,6 +46,7 @@ public:
     this->pin = pin;
     this->flags = flags;
     changed = 0;
+    pool = NULL;
   }
 
   /// Value accessor
@@ -57,6 +61,7 @@ public:
   ObjMsgSample mode;
   GpioFlags flags;
   int8_t changed; // value {+1, 0, -1} == changed to {on, none, off}
+  ObjMsgGpioPool *pool; // CHANGE_EVENT data, sent from isr_handler
 
   uint8_t value; // Measured value
 };
@@ -65,9 +70,8 @@ public:
 class GpioHost : public ObjMsgHost
 {
 public:
-  unordered_map<string, GpioPort *> ports;
+  unordered_map<uint16_t, GpioPort *> ports; ///< Ports, by name ID
   bool anyChangeEvents;
-  QueueHandle_t event_queue;
 
   /// Constructor, specifying transport object and origin
   /// @param transport: Transport object
@@ -75,7 +79,9 @@ public:
   GpioHost(ObjMsgTransport *transport, uint16_t origin)
       : ObjMsgHost(transport, "GpioHost", origin)
   {
-    event_queue = NULL;
+    // Edge events must not be lost; isr_handler cannot wait, so uses the
+    // lane's overflow slots
+    overflow = SPILL_OVERFLOW;
   }
 
   /// Add 'pin' as 'name', to operate in 'mode' and configured by 'flags'
@@ -86,8 +92,13 @@ public:
   /// @return created GpioPort
   GpioPort *Add(string name, gpio_num_t pin, ObjMsgSample mode, GpioFlags flags)
   {
-    ports[name] = new GpioPort(name, pin, mode, flags, this);
-    GpioPort *tmp = ports[name];
+    if (ObjMsgData::InternName(name) == OBJMSG_NO_NAME)
+    {
+      ESP_LOGE(TAG.c_str(), "Add(%s): name table full", name.c_str());
+      return NULL;
+    }
+    GpioPort *tmp = new GpioPort(name, pin, mode, flags, this);
+    ports[ObjMsgData::InternName(name)] = tmp;
 
     if (mode == CHANGE_EVENT)
     {
@@ -136,7 +147,34 @@ public:
 
   bool Consume(ObjMsgData *data)
   {
-    GpioPort *port = GetPort(data->GetName());
+    return ConsumePort(GetPort(data->GetNameId()), data);
+  }
+
+  /// Consume subscribed data; 'context' is the GpioPort
+  bool ConsumeTopic(ObjMsgData *data, void *context)
+  {
+    return ConsumePort((GpioPort *)context, data);
+  }
+
+  /// Subscribe each output port to data of the same name from 'fromOrigin'
+  /// @param fromOrigin: origin of data to consume
+  void SubscribeFrom(uint16_t fromOrigin)
+  {
+    for (unordered_map<uint16_t, GpioPort *>::iterator it = ports.begin(); it != ports.end(); it++)
+    {
+      if (!(it->second->flags & IS_INPUT_GF))
+      {
+        transport->Subscribe(fromOrigin, it->second->name, this, it->second);
+      }
+    }
+  }
+
+  /// Set output 'port' from 'data'
+  /// @param port: port to set (may be NULL)
+  /// @param data: data containing level
+  /// @return false
+  bool ConsumePort(GpioPort *port, ObjMsgData *data)
+  {
     if (port)
     {
       int level;
@@ -152,12 +190,12 @@ public:
           gpio_set_level(port->pin, level);
         }
         else {
-           ESP_LOGE(TAG.c_str(), "%s, Cannot consume GPIO input", data->GetName().c_str());
+           ESP_LOGE(TAG.c_str(), "%s, Cannot consume GPIO input", data->GetName().data());
         }
       }
       else
       {
-        ESP_LOGW(TAG.c_str(), "GPIO %s not found", data->GetName().c_str());
+        ESP_LOGW(TAG.c_str(), "GPIO %s not found", data->GetName().data());
       }
     }
     return false;
@@ -167,11 +205,7 @@ public:
   {
     if (anyChangeEvents)
     {
-      unordered_map<string, GpioPort *>::iterator it;
-
-      event_queue = xQueueCreate(10, sizeof(void *));
-      xTaskCreate(input_task, "gpio_input_task",
-                  CONFIG_ESP_MINIMAL_SHARED_STACK_SIZE + 50, this, 10, NULL);
+      unordered_map<uint16_t, GpioPort *>::iterator it;
 
       // install gpio isr service
       gpio_install_isr_service(0);
@@ -181,6 +215,7 @@ public:
         GpioPort *port = it->second;
         if (port->mode == CHANGE_EVENT)
         {
+          port->pool = new ObjMsgGpioPool(origin_id, port->name.c_str(), GPIO_ISR_POOL_DEPTH, 0);
           gpio_isr_handler_add(port->pin, isr_handler, port);
         }
       }
@@ -193,7 +228,7 @@ public:
   /// @return measured value, or INT_MIN if 'name' is not a GpioPort
   int Measure(string name)
   {
-    GpioPort *port = GetPort(name);
+    GpioPort *port = GetPort(ObjMsgData::InternName(name));
     if (port)
     {
       return Measure(port);
@@ -226,9 +261,9 @@ public:
   }
 
 protected:
-  GpioPort *GetPort(string name)
+  GpioPort *GetPort(uint16_t nameId)
   {
-    unordered_map<string, GpioPort *>::iterator found = ports.find(name);
+    unordered_map<uint16_t, GpioPort *>::iterator found = ports.find(nameId);
     if (found != ports.end())
     {
       return found->second;
@@ -238,31 +273,27 @@ protected:
       return NULL;
     }
   }
-  static void input_task(void *arg)
+  /// Measure 'port' and send its value directly from the interrupt, using
+  /// preallocated data from the port's pool
+  static void isr_handler(void *arg)
   {
-    GpioHost *host = (GpioHost *)arg;
-    for (;;)
+    GpioPort *port = (GpioPort *)arg;
+    GpioHost *host = port->host;
+    host->Measure(port);
+    // Value changed OR Interrup only on one edge
+    if ((port->changed) || ((port->flags & (POS_EVENT_GF | NEG_EVENT_GF)) != (POS_EVENT_GF | NEG_EVENT_GF)))
     {
-      GpioPort *port = NULL;
-      if (xQueueReceive(host->event_queue, &port, portMAX_DELAY))
+      const ObjMsgDataRef *point = port->pool->Take();
+      if (point)
       {
-        host->Measure(port);
-        // Value changed OR Interrup only on one edge
-        if ((port->changed) || ((port->flags & (POS_EVENT_GF | NEG_EVENT_GF)) != (POS_EVENT_GF | NEG_EVENT_GF)))
-        {
-          ObjMsgDataRef point = ObjMsgGpioData::Create(host->origin_id, port->name.c_str(), port->value);
-          host->Produce(point);
-        }
+        BaseType_t woken = pdFALSE;
+        static_cast<ObjMsgGpioData *>(point->get())->SetRawValue(port->value);
+        host->transport->SendFromISR(*point, host->priority, host->overflow, &woken);
+        portYIELD_FROM_ISR(woken);
       }
     }
   }
 
-  static void isr_handler(void *arg)
-  {
-    GpioPort *port = (GpioPort *)arg;
-    xQueueSendFromISR(port->host->event_queue, &port, NULL);
-  }
-
 private:
   gpio_int_type_t EdgeConfig(int flags)
   {
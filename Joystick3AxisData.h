@@ -20,7 +20,7 @@ typedef struct
 } Joystick3AxisSample_t;
 
 // ObjMsgDataT<Joystick3AxisSample_t>,  with joystick data structure value
-class Joystick3AxisData : public ObjMsgDataT<Joystick3AxisSample_t>
+class Joystick3AxisData : public ObjMsgDataT<Joystick3AxisSample_t, Joystick3AxisData>
 {
 public:
   /// Constructor
@@ -28,21 +28,35 @@ public:
   /// @param name: Data object name
   /// @param value: initial value
   Joystick3AxisData(uint16_t origin, char const *name, Joystick3AxisSample_t value)
-      : ObjMsgDataT<Joystick3AxisSample_t>(origin, name)
+      : ObjMsgDataT<Joystick3AxisSample_t, Joystick3AxisData>(origin, name)
   {
     this->value = value;
-    // ESP_LOGI(TAG.c_str(), "Joystick3AxisData(%u, %s, %u) constructed", origin, name, value);
+    // ESP_LOGI(GetTag(), "Joystick3AxisData(%u, %s, %u) constructed", origin, name, value);
   }
   /// Constructor without initial value
   /// @param origin: Data origin
   /// @param name: Data object name
   Joystick3AxisData(uint16_t origin, char const *name)
-      : ObjMsgDataT<Joystick3AxisSample_t>(origin, name) {}
+      : ObjMsgDataT<Joystick3AxisSample_t, Joystick3AxisData>(origin, name) {}
+  /// Constructor, for a name already interned
+  /// @param origin: Data origin
+  /// @param nameId: Data object name ID, from InternName()
+  /// @param value: initial value
+  Joystick3AxisData(uint16_t origin, uint16_t nameId, Joystick3AxisSample_t value)
+      : ObjMsgDataT<Joystick3AxisSample_t, Joystick3AxisData>(origin, nameId)
+  {
+    this->value = value;
+  }
+  /// Constructor, for a name already interned, without initial value
+  /// @param origin: Data origin
+  /// @param nameId: Data object name ID, from InternName()
+  Joystick3AxisData(uint16_t origin, uint16_t nameId)
+      : ObjMsgDataT<Joystick3AxisSample_t, Joystick3AxisData>(origin, nameId) {}
 
   /// Destructor
   ~Joystick3AxisData()
   {
-    // ESP_LOGI(TAG.c_str(), "Joystick3AxisData destructed");
+    // ESP_LOGI(GetTag(), "Joystick3AxisData destructed");
   }
 
   /// Create object and return in ObjMsgDataRef
@@ -52,7 +66,7 @@ public:
   /// @return created object
   static ObjMsgDataRef Create(uint16_t origin, char const *name, Joystick3AxisSample_t value)
   {
-    return std::make_shared<Joystick3AxisData>(origin, name, value);
+    return ObjMsgDataRef(new Joystick3AxisData(origin, name, value));
   }
 
   /// Create object and return in ObjMsgDataRef
@@ -61,7 +75,27 @@ public:
   /// @return created object
   static ObjMsgDataRef Create(uint16_t origin, char const *name)
   {
-    return std::make_shared<Joystick3AxisData>(origin, name);
+    return ObjMsgDataRef(new Joystick3AxisData(origin, name));
+  }
+
+  /// Create object, for a name already interned, and return in ObjMsgDataRef
+  /// @param origin: Data origin
+  /// @param nameId: Data object name ID, from InternName()
+  /// @param value: initial value
+  /// @return created object
+  static ObjMsgDataRef Create(uint16_t origin, uint16_t nameId, Joystick3AxisSample_t value)
+  {
+    return ObjMsgDataRef(new Joystick3AxisData(origin, nameId, value));
+  }
+
+  /// Create object, for a name already interned, as registered with the
+  /// factory
+  /// @param origin: Data origin
+  /// @param nameId: Data object name ID, from InternName()
+  /// @return created object
+  static ObjMsgDataRef Create(uint16_t origin, uint16_t nameId)
+  {
+    return ObjMsgDataRef(new Joystick3AxisData(origin, nameId));
   }
 
   bool DeserializeValue(cJSON *json)
@@ -74,6 +108,43 @@ public:
     return true;
   }
 
+  /// Read the flat {"x":..} object without cJSON
+  bool DeserializeValue(string_view json)
+  {
+    ObjMsgJsonReader reader(json);
+    string_view key, item;
+    int64_t tmp;
+    int found = 0;
+    while (reader.Next(key, item))
+    {
+      if (!ObjMsgJsonReader::Int(item, tmp))
+      {
+        return false;
+      }
+      if (key == "x")
+      {
+        value.x = tmp;
+        found |= 1;
+      }
+      else if (key == "y")
+      {
+        value.y = tmp;
+        found |= 2;
+      }
+      else if (key == "z")
+      {
+        value.z = tmp;
+        found |= 4;
+      }
+      else if (key == "up")
+      {
+        value.up = tmp;
+        found |= 8;
+      }
+    }
+    return reader.Done() && found == 15;
+  }
+
   bool GetValue(int &val)
   {
     // val = value;
@@ -87,10 +158,24 @@ public:
   bool GetValue(string &str)
   {
     char buffer[80];
-    sprintf(buffer, " { \"x\":%d, \"y\":%d, \"z\":%d, \"up\":%d }",
-            value.x, value.y, value.z, value.up);
-    str = buffer;
+    ObjMsgJsonWriter writer(buffer, sizeof(buffer));
+    SerializeValue(writer);
+    str.assign(buffer, writer.Length());
+
+    return true;
+  }
 
+  bool SerializeValue(ObjMsgJsonWriter &writer)
+  {
+    writer.Raw("{\"x\":");
+    writer.Int(value.x);
+    writer.Raw(",\"y\":");
+    writer.Int(value.y);
+    writer.Raw(",\"z\":");
+    writer.Int(value.z);
+    writer.Raw(",\"up\":");
+    writer.Int(value.up);
+    writer.Char('}');
     return true;
   }
 };
@@ -32,6 +32,11 @@ public:
   {
     this->sampleIntervalMs = sampleIntervalMs;
     anyChangeEvents = false;
+    // Joystick samples are latency critical control data; only the
+    // latest position matters, but button changes are never conflated
+    priority = HIGH_PRIORITY;
+    conflate = true;
+    overflow = DROP_OLDEST;
   }
 
   /// Add joystick as 'name', to operate in 'mode' with analog channels 'ad_x' and
@@ -46,6 +51,11 @@ public:
   int Add(string name, ObjMsgSample mode, adc_channel_t ad_x, 
     adc_channel_t ad_y, adc_channel_t ad_z, gpio_num_t btn)
   {
+    if (ObjMsgData::InternName(name) == OBJMSG_NO_NAME)
+    {
+      ESP_LOGE(TAG.c_str(), "Add(%s): name table full", name.c_str());
+      return -1;
+    }
     joysticks[name] = new Joystick3Axis(name, mode);
     Joystick3Axis *joy = joysticks[name];
 
@@ -104,13 +114,16 @@ protected:
       int hysteresis = 5)
     {
       this->name = name;
+      this->nameId = ObjMsgData::InternName(name);
       this->mode = mode;
       this->centered = false;
       this->changed = 0;
+      this->clicked = false;
       this->hysteresis = hysteresis;
       memset(&sample, 0, sizeof(sample));
     }
     string name;
+    uint16_t nameId; ///< Interned name, for producing data
     // Configuration
     AdcChannel *xchan;
     AdcChannel *ychan;
@@ -122,6 +135,7 @@ protected:
     ObjMsgSample mode;
     int hysteresis;
     int16_t changed;
+    bool clicked; ///< Button changed in the last Measure()
     Joystick3AxisSample_t sample;
   };
 
@@ -161,8 +175,17 @@ protected:
           if (ep->Measure(js))
           {
             ObjMsgDataRef data = Joystick3AxisData::Create(
-              ep->origin_id, js->name.c_str(), js->sample);
-            ep->Produce(data);
+              ep->origin_id, js->nameId, js->sample);
+            // A button change is an event: a later sample must not
+            // replace it before it is received
+            if (js->clicked)
+            {
+              ep->ProduceEvent(std::move(data));
+            }
+            else
+            {
+              ep->Produce(std::move(data));
+            }
           }
         }
       }
@@ -190,6 +213,8 @@ protected:
     reading_y /= NO_OF_SAMPLES;
     reading_z /= NO_OF_SAMPLES;
 
+    js->clicked = sample->up != up;
+
     // Use first sample value for initial center position
     if (!js->centered)
     {
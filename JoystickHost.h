@@ -32,6 +32,11 @@ public:
   {
     this->sampleIntervalMs = sampleIntervalMs;
     anyChangeEvents = false;
+    // Joystick samples are latency critical control data; only the
+    // latest position matters, but button changes are never conflated
+    priority = HIGH_PRIORITY;
+    conflate = true;
+    overflow = DROP_OLDEST;
   }
 
   /// Add joystick as 'name', to operate in 'mode' with analog channels 'ad_x' and
@@ -45,6 +50,11 @@ public:
   int Add(string name, ObjMsgSample mode, 
     adc_channel_t ad_x, adc_channel_t ad_y, gpio_num_t btn)
   {
+    if (ObjMsgData::InternName(name) == OBJMSG_NO_NAME)
+    {
+      ESP_LOGE(TAG.c_str(), "Add(%s): name table full", name.c_str());
+      return -1;
+    }
     joysticks[name] = new Joystick(name, mode);
     Joystick *joy = joysticks[name];
 
@@ -100,13 +110,16 @@ protected:
       int hysteresis = 5)
     {
       this->name = name;
+      this->nameId = ObjMsgData::InternName(name);
       this->mode = mode;
       this->centered = false;
       this->changed = 0;
+      this->clicked = false;
       this->hysteresis = hysteresis;
       memset(&sample, 0, sizeof(sample));
     }
     string name;
+    uint16_t nameId; ///< Interned name, for producing data
     // Configuration
     AdcChannel *xchan;
     AdcChannel *ychan;
@@ -117,6 +130,7 @@ protected:
     ObjMsgSample mode;
     int hysteresis;
     int16_t changed;
+    bool clicked; ///< Button changed in the last Measure()
     joystick_sample_t sample;
   };
 
@@ -156,8 +170,17 @@ protected:
           if (ep->Measure(js))
           {
             ObjMsgDataRef data = ObjMsgJoystickData::Create(
-              ep->origin_id, js->name.c_str(), js->sample);
-            ep->Produce(data);
+              ep->origin_id, js->nameId, js->sample);
+            // A button change is an event: a later sample must not
+            // replace it before it is received
+            if (js->clicked)
+            {
+              ep->ProduceEvent(std::move(data));
+            }
+            else
+            {
+              ep->Produce(std::move(data));
+            }
           }
         }
       }
@@ -182,6 +205,8 @@ protected:
     reading_x /= NO_OF_SAMPLES;
     reading_y /= NO_OF_SAMPLES;
 
+    js->clicked = sample->up != up;
+
     // Use first sample value for initial center position
     if (!js->centered)
     {
@@ -27,6 +27,7 @@ class LvglHost : public ObjMsgHost
   typedef struct
   {
     const char *name;
+    uint16_t nameId; ///< Interned name, for producing data
     lv_obj_t *obj;
     enum ControlType type;
     lv_event_code_t eventCode;
@@ -47,7 +48,13 @@ public:
   /// @return boolean success
   int AddVirtualConsumer(const char *name, lvglVirtualComsumer consumer)
   {
-    virtual_consume_map[name] = consumer;
+    uint16_t nameId = ObjMsgData::InternName(name);
+    if (nameId == OBJMSG_NO_NAME)
+    {
+      ESP_LOGE(TAG.c_str(), "AddVirtualConsumer(%s): name table full", name);
+      return false;
+    }
+    virtual_consume_map[nameId] = consumer;
 
     return true;
   }
@@ -60,8 +67,13 @@ public:
   int AddConsumer(const char *name, lv_obj_t *control, enum ControlType binding)
   {
     // Note: eventCode member of control_reg_def_t is NOT used for a counsumer
-    control_reg_def_t def = {.name = name, .obj = control, .type = binding, .eventCode = LV_EVENT_ALL};
-    consume_map[name] = def;
+    control_reg_def_t def = {.name = name, .nameId = ObjMsgData::InternName(name), .obj = control, .type = binding, .eventCode = LV_EVENT_ALL};
+    if (def.nameId == OBJMSG_NO_NAME)
+    {
+      ESP_LOGE(TAG.c_str(), "AddConsumer(%s): name table full", name);
+      return false;
+    }
+    consume_map[def.nameId] = def;
 
     return true;
   }
@@ -73,7 +85,12 @@ public:
   /// @return boolean success
   int AddProducer(const char *name, lv_obj_t *control, enum ControlType binding, lv_event_code_t eventCode)
   {
-    control_reg_def_t def = {.name = name, .obj = control, .type = binding, .eventCode = eventCode};
+    control_reg_def_t def = {.name = name, .nameId = ObjMsgData::InternName(name), .obj = control, .type = binding, .eventCode = eventCode};
+    if (def.nameId == OBJMSG_NO_NAME)
+    {
+      ESP_LOGE(TAG.c_str(), "AddProducer(%s): name table full", name);
+      return false;
+    }
     produce_map[control] = def;
 
     // Store this object in user_data for lookup
@@ -89,7 +106,7 @@ public:
 
   bool Produce(ObjMsgDataRef data)
   {
-    return transport->Send(data);
+    return transport->Send(std::move(data), priority, conflate, overflow);
   }
 
   bool Consume(ObjMsgData *msg)
@@ -100,11 +117,27 @@ public:
     return result;
   }
 
+  /// Consume 'batch' holding the display lock once
+  int ConsumeBatch(span<ObjMsgData *> batch)
+  {
+    int consumed = 0;
+    lock(0);
+    for (ObjMsgData *msg : batch)
+    {
+      if (_consume(msg))
+      {
+        ++consumed;
+      }
+    }
+    unlock();
+    return consumed;
+  }
+
   bool _consume(ObjMsgData *msg)
   {
     string strVal;
     int intVal;
-    lvglVirtualComsumer vrt = GetVirtualConsumer(msg->GetName());
+    lvglVirtualComsumer vrt = GetVirtualConsumer(msg->GetNameId());
 
     if (vrt)
     {
@@ -112,7 +145,7 @@ public:
     }
     else
     {
-      control_reg_def_t *ctx = GetConsumer(msg->GetName());
+      control_reg_def_t *ctx = GetConsumer(msg->GetNameId());
       if (ctx)
       {
         switch (ctx->type)
@@ -124,7 +157,7 @@ public:
           }
           else
           {
-            ESP_LOGE(TAG.c_str(), "consume name (%s) value must be integer", msg->GetName().c_str());
+            ESP_LOGE(TAG.c_str(), "consume name (%s) value must be integer", msg->GetName().data());
             return false;
           }
           break;
@@ -142,7 +175,7 @@ public:
           }
           else
           {
-            ESP_LOGE(TAG.c_str(), "consume (%s) button value must be integer", msg->GetName().c_str());
+            ESP_LOGE(TAG.c_str(), "consume (%s) button value must be integer", msg->GetName().data());
             return false;
           }
           break;
@@ -152,7 +185,7 @@ public:
           break;
         case TEXTAREA_CT:
           msg->GetValue(strVal);
-          // printf("setting %s to %s\n", msg->GetName().c_str(), strVal.c_str());
+          // printf("setting %s to %s\n", msg->GetName().data(), strVal.c_str());
           lv_textarea_set_text(ctx->obj, strVal.c_str());
           break;
         case CALENDAR_CT:
@@ -185,7 +218,7 @@ public:
           }
           else
           {
-            ESP_LOGE(TAG.c_str(), "consume name (%s) value must be integer", msg->GetName().c_str());
+            ESP_LOGE(TAG.c_str(), "consume name (%s) value must be integer", msg->GetName().data());
             return false;
           }
           break;
@@ -198,7 +231,7 @@ public:
           }
           else
           {
-            ESP_LOGE(TAG.c_str(), "consume name (%s) value must be (RGB encoded) integer", msg->GetName().c_str());
+            ESP_LOGE(TAG.c_str(), "consume name (%s) value must be (RGB encoded) integer", msg->GetName().data());
             return false;
           }
           break;
@@ -222,7 +255,7 @@ public:
           }
           else
           {
-            ESP_LOGE(TAG.c_str(), "consume name (%s) value must be integer", msg->GetName().c_str());
+            ESP_LOGE(TAG.c_str(), "consume name (%s) value must be integer", msg->GetName().data());
             return false;
           }
           break;
@@ -240,7 +273,7 @@ public:
           }
           else
           {
-            ESP_LOGE(TAG.c_str(), "consume name (%s) value must be integer", msg->GetName().c_str());
+            ESP_LOGE(TAG.c_str(), "consume name (%s) value must be integer", msg->GetName().data());
             return false;
           }
           break;
@@ -251,7 +284,7 @@ public:
       }
       else
       {
-        ESP_LOGI(TAG.c_str(), "consume name (%s) NOT REGISTERED", msg->GetName().c_str());
+        ESP_LOGI(TAG.c_str(), "consume name (%s) NOT REGISTERED", msg->GetName().data());
         return false;
       }
       return true;
@@ -273,23 +306,23 @@ protected:
         {
         case ARC_CT:
           data = ObjMsgDataInt::Create(
-              host->origin_id, ctx->name, lv_arc_get_value(ctx->obj));
-          host->Produce(data);
+              host->origin_id, ctx->nameId, lv_arc_get_value(ctx->obj));
+          host->Produce(std::move(data));
           break;
         case BUTTON_CT:
-          data = ObjMsgDataInt::Create(host->origin_id, ctx->name,
+          data = ObjMsgDataInt::Create(host->origin_id, ctx->nameId,
                                        (lv_obj_get_state(ctx->obj) & LV_STATE_PRESSED) ? 1 : 0);
-          host->Produce(data);
+          host->Produce(std::move(data));
           break;
         case LABEL_CT:
           data = ObjMsgDataString::Create(
-              host->origin_id, ctx->name, lv_label_get_text(ctx->obj));
-          host->Produce(data);
+              host->origin_id, ctx->nameId, lv_label_get_text(ctx->obj));
+          host->Produce(std::move(data));
           break;
         case TEXTAREA_CT:
           data = ObjMsgDataString::Create(
-              host->origin_id, ctx->name, lv_textarea_get_text(ctx->obj));
-          host->Produce(data);
+              host->origin_id, ctx->nameId, lv_textarea_get_text(ctx->obj));
+          host->Produce(std::move(data));
           break;
         case CALENDAR_CT:
         {
@@ -299,29 +332,29 @@ protected:
           sprintf(buffer, "{ \"year:\" %d, \"month:\" %d, \"day:\" %d }",
                   date.year, date.month - 1, date.day);
           data = ObjMsgDataString::Create(
-              host->origin_id, ctx->name, buffer, true);
-          host->Produce(data);
+              host->origin_id, ctx->nameId, buffer, true);
+          host->Produce(std::move(data));
           break;
         }
         case CHECKBOX_CT:
-          data = ObjMsgDataInt::Create(host->origin_id, ctx->name,
+          data = ObjMsgDataInt::Create(host->origin_id, ctx->nameId,
                                        (lv_obj_get_state(ctx->obj) & LV_STATE_CHECKED) ? 1 : 0);
-          host->Produce(data);
+          host->Produce(std::move(data));
           break;
         case COLORWHEEL_CT:
         {
           lv_color_t color = lv_colorwheel_get_rgb(ctx->obj);
           data = ObjMsgDataInt::Create(
-              host->origin_id, ctx->name, color.full);
-          host->Produce(data);
+              host->origin_id, ctx->nameId, color.full);
+          host->Produce(std::move(data));
           break;
         }
         case DROPDOWN_CT:
         {
           char buf[40];
           lv_dropdown_get_selected_str(ctx->obj, buf, sizeof(buf));
-          data = ObjMsgDataString::Create(host->origin_id, ctx->name, buf);
-          host->Produce(data);
+          data = ObjMsgDataString::Create(host->origin_id, ctx->nameId, buf);
+          host->Produce(std::move(data));
           break;
         }
         case ROLLER_CT:
@@ -329,8 +362,8 @@ protected:
           char buf[40];
           lv_roller_get_selected_str(ctx->obj, buf, sizeof(buf));
           data = ObjMsgDataString::Create(
-              host->origin_id, ctx->name, buf);
-          host->Produce(data);
+              host->origin_id, ctx->nameId, buf);
+          host->Produce(std::move(data));
           break;
         }
         case IMGBUTTON_CT:
@@ -339,13 +372,13 @@ protected:
           break;
         case SLIDER_CT:
           data = ObjMsgDataInt::Create(
-              host->origin_id, ctx->name, lv_slider_get_value(ctx->obj));
-          host->Produce(data);
+              host->origin_id, ctx->nameId, lv_slider_get_value(ctx->obj));
+          host->Produce(std::move(data));
           break;
         case SWITCH_CT:
           data = ObjMsgDataInt::Create(
-              host->origin_id, ctx->name, lv_obj_has_state(ctx->obj, LV_STATE_CHECKED) ? 1 : 0);
-          host->Produce(data);
+              host->origin_id, ctx->nameId, lv_obj_has_state(ctx->obj, LV_STATE_CHECKED) ? 1 : 0);
+          host->Produce(std::move(data));
           break;
         default:
           ESP_LOGE(host->TAG.c_str(), "produce type (%d) NOT IMPLEMENTED", ctx->type);
@@ -364,9 +397,9 @@ protected:
     }
   }
 
-  control_reg_def_t *GetConsumer(string name)
+  control_reg_def_t *GetConsumer(uint16_t nameId)
   {
-    unordered_map<string, control_reg_def_t>::iterator found = consume_map.find(name);
+    unordered_map<uint16_t, control_reg_def_t>::iterator found = consume_map.find(nameId);
     if (found != consume_map.end())
     {
       return &found->second;
@@ -376,9 +409,9 @@ protected:
       return NULL;
     }
   }
-  lvglVirtualComsumer GetVirtualConsumer(string name)
+  lvglVirtualComsumer GetVirtualConsumer(uint16_t nameId)
   {
-    unordered_map<string, lvglVirtualComsumer>::iterator found = virtual_consume_map.find(name);
+    unordered_map<uint16_t, lvglVirtualComsumer>::iterator found = virtual_consume_map.find(nameId);
     if (found != virtual_consume_map.end())
     {
       return found->second;
@@ -401,7 +434,8 @@ protected:
       return NULL;
     }
   }
-  std::unordered_map<std::string, control_reg_def_t> consume_map;
-  std::unordered_map<std::string, lvglVirtualComsumer> virtual_consume_map;
+  /// Consumers, by name ID
+  std::unordered_map<uint16_t, control_reg_def_t> consume_map;
+  std::unordered_map<uint16_t, lvglVirtualComsumer> virtual_consume_map;
   std::unordered_map<lv_obj_t *, control_reg_def_t> produce_map;
 };
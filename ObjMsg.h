@@ -6,11 +6,20 @@
 #include <freertos/task.h>
 #include "freertos/semphr.h"
 #include <esp_log.h>
+#include <esp_timer.h>
 
 #include <string>
+#include <string_view>
+#include <deque>
 #include <unordered_map>
 #include <list>
+#include <vector>
+#include <algorithm>
 #include <memory>
+#include <atomic>
+#include <functional>
+#include <type_traits>
+#include <span>
 
 #include "cJSON.h"
 #include "ObjMsgData.h"
@@ -20,8 +29,46 @@ using namespace std;
 /** Message queue macros
  */
 #define MSG_QUEUE_MAX_DEPTH 10
+/// Maximum messages delivered by one ObjMsgTransport::ReceiveBatch()
+#define MSG_BATCH_MAX_DEPTH 16
+/// Maximum distinct consumers given one ConsumeBatch() per batch; others
+/// are handed the batch members one at a time
+#define MSG_BATCH_MAX_CONSUMERS 16
+
+/// Transport priority class. Each has its own lane (queue) in ObjMsgTransport
+enum ObjMsgPriority
+{
+  HIGH_PRIORITY,   /**< Latency critical control data */
+  NORMAL_PRIORITY, /**< Default */
+  LOW_PRIORITY,    /**< Bulk / informational data */
+  PRIORITY_COUNT
+};
+
+/// ObjMsgTransport::Send() policy when the lane is full
+enum ObjMsgOverflow
+{
+  DEFAULT_OVERFLOW, /**< Use the transport's policy (see SetOverflow()) */
+  DROP_NEWEST,      /**< Reject the message being sent */
+  DROP_OLDEST,      /**< Discard the sender's oldest waiting message to make room */
+  BLOCK_OVERFLOW,   /**< Wait, up to a timeout, for a free slot */
+  SPILL_OVERFLOW    /**< Use the lane's bounded overflow slots, then drop newest */
+};
+
+/// Default maximum wait for BLOCK_OVERFLOW
+#define MSG_OVERFLOW_BLOCK_MS 20
+/// Default overflow slots per lane, usable only by SPILL_OVERFLOW sends
+#define MSG_SPILL_DEPTH 4
+
+/// Order in which ObjMsgTransport::Receive() drains priority lanes
+enum ObjMsgDrain
+{
+  STRICT_DRAIN,  /**< Always the highest priority waiting message */
+  WEIGHTED_DRAIN /**< Round robin, up to lane weight messages per round */
+};
 
 class ObjMsgTransport;
+class ObjMsgDispatcher;
+class ObjMsgWorker;
 
 /*
  *      _  _        _
@@ -47,6 +94,12 @@ protected:
   ObjMsgTransport *transport; ///< transport used to send content
   const string TAG; ///< TAG for log messages
   const uint16_t origin_id; ///< Name for log messages from ths instance
+  ObjMsgPriority priority; ///< Transport priority for produced data
+  bool conflate; ///< Produced data replaces older waiting data with the same name
+  ObjMsgOverflow overflow; ///< Transport full policy for produced data
+  int8_t dispatchWorker; ///< ObjMsgDispatcher worker running Consume(), or -1 if unassigned
+  ObjMsgWorker *inbox; ///< Private task running Consume(), or NULL to consume in the router
+  friend class ObjMsgDispatcher;
 
 public:
   /// Constructor , specifying transport object, tag and origin
@@ -54,7 +107,8 @@ public:
   /// @param tag: Name for log messages
   /// @param origin: Origin ID for this host
   ObjMsgHost(ObjMsgTransport *transport, const char *tag, uint16_t origin)
-      : transport(transport), TAG(tag), origin_id(origin) {}
+      : transport(transport), TAG(tag), origin_id(origin), priority(NORMAL_PRIORITY), conflate(false),
+        overflow(DEFAULT_OVERFLOW), dispatchWorker(-1), inbox(NULL) {}
 
   /// Consume provided data
   ///
@@ -62,13 +116,48 @@ public:
   /// @return true if successfully consumed, false if not registered as consumer or unable to use data
   virtual bool Consume(ObjMsgData *data) { return false; }
 
+  /// Consume data delivered by a topic subscription
+  ///
+  /// Override to use 'context' (for example, the resource bound to the
+  /// subscribed name) rather than looking the name up again
+  /// @param data - data to consume
+  /// @param context - context provided to ObjMsgTransport::Subscribe()
+  /// @return true if successfully consumed
+  virtual bool ConsumeTopic(ObjMsgData *data, void *context) { return Consume(data); }
+
+  /// Consume a batch of data, in order
+  ///
+  /// Override to amortize per message work (locks, frames) across the batch
+  /// @param batch - data to consume
+  /// @return number of data successfully consumed
+  virtual int ConsumeBatch(span<ObjMsgData *> batch)
+  {
+    int consumed = 0;
+    for (ObjMsgData *data : batch)
+    {
+      if (Consume(data))
+      {
+        ++consumed;
+      }
+    }
+    return consumed;
+  }
+
   /// Produce provided data
   ///
-  /// use transport to Send provided data
+  /// use transport to Send provided data at this host's priority
   /// @param data - data to send
   /// @return boolean success
   virtual bool Produce(ObjMsgDataRef data); // Implemented in ObjMsgDataFactory.cpp
 
+  /// Produce provided data as a discrete event
+  ///
+  /// As Produce(), but never conflatable, whatever SetConflate(), so that
+  /// a later sample cannot replace it while it waits to be received
+  /// @param data - data to send
+  /// @return boolean success
+  bool ProduceEvent(ObjMsgDataRef data); // Implemented in ObjMsgDataFactory.cpp
+
   /// Produce data created by parsing a JSON encoded message
   ///
   /// WARNING - for now, uses global dataFactory
@@ -80,7 +169,7 @@ public:
     ObjMsgDataRef data = ObjMsgData::Deserialize(origin_id, message);
     if (data)
     {
-      return Produce(data) ? true : false;
+      return Produce(std::move(data)) ? true : false;
     }
     return false;
   }
@@ -92,6 +181,267 @@ public:
   /// Get the origin ID for this host
   /// @return the origin ID
   uint16_t GetOrigin() { return origin_id; }
+
+  /// Set the transport priority used by Produce()
+  /// @param priority: priority class for produced data
+  void SetPriority(ObjMsgPriority priority) { this->priority = priority; }
+
+  /// Set whether Produce() sends conflatable (latest value only) data
+  /// @param conflate: replace older waiting data with the same name
+  void SetConflate(bool conflate) { this->conflate = conflate; }
+
+  /// Set the transport full policy used by Produce()
+  /// @param overflow: policy; DEFAULT_OVERFLOW uses the transport's policy
+  void SetOverflow(ObjMsgOverflow overflow) { this->overflow = overflow; }
+
+  /// Consume in a private inbox task, so slow Consume() calls (blocking I/O)
+  /// do not stall the transport; forwarding then only enqueues to the inbox
+  ///
+  /// Call once, during startup, before the transport is frozen
+  /// @param depth: maximum waiting data
+  /// @param taskPriority: inbox task priority
+  /// @param core: core to pin the inbox task to, or tskNO_AFFINITY
+  /// @param conflate: replace waiting data with newer data of the same origin and name
+  /// @param stackSize: inbox task stack size
+  /// @return boolean success; false if already set, or the transport is frozen
+  bool SetInbox(uint16_t depth, UBaseType_t taskPriority, BaseType_t core = tskNO_AFFINITY,
+                bool conflate = false, uint32_t stackSize = CONFIG_ESP_MINIMAL_SHARED_STACK_SIZE + 2048); // Implemented in ObjMsgDataFactory.cpp
+
+  /// Get the inbox task, if any
+  /// @return inbox, or NULL if consuming in the router
+  ObjMsgWorker *GetInbox() { return inbox; }
+};
+
+/*
+ *     __      __       _
+ *     \ \    / /__ _ _| |_____ _ _
+ *      \ \/\/ / _ \ '_| / / -_) '_|
+ *       \_/\_/\___/_| |_\_\___|_|
+ *
+ */
+
+/// Worker statistics
+typedef struct
+{
+  uint32_t jobs;       ///< Jobs posted
+  uint32_t dropped;    ///< Jobs rejected because the worker was full
+  uint32_t conflated;  ///< Jobs that replaced waiting data
+  uint32_t serviced;   ///< Jobs consumed
+  uint16_t depth;      ///< Job capacity
+  uint16_t waiting;    ///< Jobs currently waiting
+  uint16_t highWater;  ///< Maximum jobs waiting
+  uint32_t serviceMaxUs;    ///< Maximum Consume() time
+  uint64_t serviceTotalUs;  ///< Sum of Consume() times (divide by 'serviced' for mean)
+} ObjMsgWorkerStats;
+
+/// A task that runs host Consume() calls posted to it, in order
+///
+/// Jobs are held in a fixed ring of slots, each sharing (not copying) the
+/// posted ObjMsgDataRef, allocated once at construction. Used by
+/// ObjMsgDispatcher, and as a host's private inbox (ObjMsgHost::SetInbox()).
+class ObjMsgWorker
+{
+  /// A posted Consume() call
+  typedef struct
+  {
+    ObjMsgDataRef dataRef; ///< Data to consume
+    ObjMsgHost *host;      ///< Consumer
+    void *context;         ///< ConsumeTopic() context
+    bool topic;            ///< Use ConsumeTopic() rather than Consume()
+  } Job;
+
+  Job *jobs;
+  uint16_t head;
+  uint16_t count;
+  bool conflate;
+  ObjMsgWorkerStats stats;
+  /// Occupied job count, for the task to wait on
+  SemaphoreHandle_t pending;
+  /// Protects job ring
+  portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+  TaskHandle_t task;
+
+  static void Task(void *arg)
+  {
+    ObjMsgWorker *worker = (ObjMsgWorker *)arg;
+    for (;;)
+    {
+      if (xSemaphoreTake(worker->pending, portMAX_DELAY))
+      {
+        Job job;
+        portENTER_CRITICAL(&worker->lock);
+        job = std::move(worker->jobs[worker->head]);
+        worker->head = (worker->head + 1) % worker->stats.depth;
+        --worker->count;
+        portEXIT_CRITICAL(&worker->lock);
+
+        int64_t start = esp_timer_get_time();
+        if (job.topic)
+        {
+          job.host->ConsumeTopic(job.dataRef.get(), job.context);
+        }
+        else
+        {
+          job.host->Consume(job.dataRef.get());
+        }
+        uint32_t service = esp_timer_get_time() - start;
+
+        portENTER_CRITICAL(&worker->lock);
+        ++worker->stats.serviced;
+        worker->stats.serviceTotalUs += service;
+        if (service > worker->stats.serviceMaxUs)
+        {
+          worker->stats.serviceMaxUs = service;
+        }
+        portEXIT_CRITICAL(&worker->lock);
+        // job.dataRef released here, outside the critical section
+      }
+    }
+  }
+
+  /// Replace the data of a waiting job for the same consumer, origin and name
+  /// @param dataRef: newer data; swapped with the replaced data
+  /// @return true if a job was replaced
+  bool Conflate(ObjMsgDataRef &dataRef, ObjMsgHost *host, void *context, bool topic)
+  {
+    for (uint16_t i = 0; i < count; i++)
+    {
+      Job &job = jobs[(head + i) % stats.depth];
+      if (job.host == host && job.context == context && job.topic == topic
+          && job.dataRef->IsFrom(dataRef->GetOrigin())
+          && job.dataRef->IsNamed(dataRef->GetNameId()))
+      {
+        job.dataRef.swap(dataRef);
+        return true;
+      }
+    }
+    return false;
+  }
+
+public:
+  /// Constructor; creates the worker task
+  /// @param name: task name
+  /// @param depth: maximum waiting jobs
+  /// @param priority: task priority
+  /// @param core: core to pin the task to, or tskNO_AFFINITY
+  /// @param stackSize: task stack size
+  /// @param conflate: replace a waiting job's data with newer data of the
+  ///   same origin and name for the same consumer, rather than queueing it
+  ObjMsgWorker(const char *name, uint16_t depth, UBaseType_t priority,
+               BaseType_t core, uint32_t stackSize, bool conflate = false)
+      : head(0), count(0), conflate(conflate), stats{}
+  {
+    jobs = new Job[depth];
+    stats.depth = depth;
+    pending = xSemaphoreCreateCounting(depth, 0);
+    xTaskCreatePinnedToCore(Task, name, stackSize, this, priority, &task, core);
+  }
+
+  /// Post a Consume() (or ConsumeTopic()) of 'dataRef' by 'host'
+  /// @param dataRef: data to consume; shared with the job
+  /// @param host: consumer
+  /// @param context: ConsumeTopic() context
+  /// @param topic: use ConsumeTopic() rather than Consume()
+  /// @return true if posted, false if the worker is full
+  bool Post(const ObjMsgDataRef &dataRef, ObjMsgHost *host, void *context, bool topic); // Implemented in ObjMsgDataFactory.cpp
+
+  /// Get worker statistics
+  /// @param stats: out value
+  void GetStats(ObjMsgWorkerStats &stats)
+  {
+    portENTER_CRITICAL(&lock);
+    stats = this->stats;
+    stats.waiting = count;
+    portEXIT_CRITICAL(&lock);
+  }
+};
+
+/*
+ *      ___  _               _      _
+ *     |   \(_)____ __  __ _| |_ __| |_
+ *     | |) | (_-< '_ \/ _` |  _/ _| ' \
+ *     |___/|_/__/ .__/\__,_|\__\__|_||_|
+ *               |_|
+ */
+
+/// Runs transport consumers on worker tasks, one per core by default
+///
+/// Each host is assigned to one worker (round robin on first use, or by
+/// Assign()), so each consumer sees data in order while different consumers
+/// run in parallel. Data is shared across workers by ObjMsgDataRef, not
+/// copied. Enable with ObjMsgTransport::SetDispatcher().
+class ObjMsgDispatcher
+{
+  ObjMsgWorker **workers;
+  uint8_t workerCount;
+  uint8_t next; ///< Next worker for round robin assignment
+
+public:
+  /// Constructor; creates 'workerCount' workers, pinned to cores in turn
+  /// @param workerCount: number of worker tasks
+  /// @param depth: maximum waiting jobs per worker
+  /// @param priority: worker task priority
+  /// @param stackSize: worker task stack size
+  ObjMsgDispatcher(uint8_t workerCount = portNUM_PROCESSORS,
+                   uint16_t depth = MSG_QUEUE_MAX_DEPTH, UBaseType_t priority = 5,
+                   uint32_t stackSize = CONFIG_ESP_MINIMAL_SHARED_STACK_SIZE + 2048)
+      : workerCount(workerCount), next(0)
+  {
+    workers = new ObjMsgWorker *[workerCount];
+    for (int i = 0; i < workerCount; i++)
+    {
+      char name[16];
+      snprintf(name, sizeof(name), "objmsg_wrk%d", i);
+      workers[i] = new ObjMsgWorker(name, depth, priority, i % portNUM_PROCESSORS, stackSize);
+    }
+  }
+
+  /// Run 'host' Consume() calls on 'worker'
+  ///
+  /// Assign before messages are received
+  /// @param host: consumer
+  /// @param worker: worker index (worker N is pinned to core N % cores)
+  void Assign(ObjMsgHost *host, uint8_t worker)
+  {
+    host->dispatchWorker = worker % workerCount;
+  }
+
+  /// Get the worker running 'host' Consume() calls, assigning one round
+  /// robin if it has none
+  /// @param host: consumer
+  /// @return the host's worker
+  ObjMsgWorker *WorkerFor(ObjMsgHost *host)
+  {
+    if (host->dispatchWorker < 0)
+    {
+      Assign(host, next++);
+    }
+    return workers[host->dispatchWorker];
+  }
+
+  /// Post Consume() (or ConsumeTopic()) of 'dataRef' by 'host' to its worker
+  /// @param dataRef: data to consume
+  /// @param host: consumer
+  /// @param context: ConsumeTopic() context
+  /// @param topic: use ConsumeTopic() rather than Consume()
+  /// @return true if posted, false if the worker is full
+  bool Dispatch(const ObjMsgDataRef &dataRef, ObjMsgHost *host, void *context, bool topic)
+  {
+    bool result = WorkerFor(host)->Post(dataRef, host, context, topic);
+    if (!result)
+    {
+      ESP_LOGW("DISPATCH", "Worker %d Overflow", host->dispatchWorker);
+    }
+    return result;
+  }
+
+  /// Get statistics for 'worker'
+  /// @param worker: worker index
+  /// @param stats: out value
+  void GetWorkerStats(uint8_t worker, ObjMsgWorkerStats &stats)
+  {
+    workers[worker % workerCount]->GetStats(stats);
+  }
 };
 
 /*
@@ -102,113 +452,947 @@ public:
  *                           |_|
  */
 
+/// Per lane transport statistics
+typedef struct
+{
+  uint32_t sent;       ///< Messages accepted by Send()
+  uint32_t received;   ///< Messages delivered by Receive()
+  uint32_t dropped;    ///< Messages rejected because the lane was full (DROP_NEWEST, or BLOCK / SPILL exhausted)
+  uint32_t evicted;    ///< Waiting messages discarded to make room (DROP_OLDEST)
+  uint32_t blocked;    ///< Sends that waited for a free slot (BLOCK_OVERFLOW)
+  uint32_t timeouts;   ///< Blocked sends that timed out (BLOCK_OVERFLOW)
+  uint32_t spilled;    ///< Messages accepted into the overflow slots (SPILL_OVERFLOW)
+  uint32_t conflated;  ///< Waiting messages replaced by a newer conflatable message
+  uint16_t depth;      ///< Lane capacity
+  uint16_t spillDepth; ///< Additional overflow slots for SPILL_OVERFLOW
+  uint16_t waiting;    ///< Messages currently waiting
+  uint16_t highWater;  ///< Maximum messages waiting
+  uint32_t latencyMaxUs;    ///< Maximum Send() to Receive() time
+  uint64_t latencyTotalUs;  ///< Sum of Send() to Receive() times (divide by 'received' for mean)
+} ObjMsgLaneStats;
+
 /// Send / Receive messages
+///
+/// Messages are held in fixed capacity rings of ObjMsgDataRef slots, one
+/// per ObjMsgPriority lane, allocated at construction so Send() / Receive()
+/// do not touch the heap. A counting semaphore tracks occupied slots across
+/// all lanes and provides the blocking Receive() wait.
 class ObjMsgTransport
 {
-  QueueHandle_t message_queue = NULL;
-  /// Class used to convey ObjMsgData messages.
-  ///
-  /// ObjMessage implementation creates a
-  /// new ObjMessage to be sent carrying a reference to requested
-  /// ObjMsgData (ObjMsgDataRef), then deletes that reference upon reception.
-  ///
-  /// The lifetime of the ObjMsgData is managed by virtue
-  /// of it's shared pointer.
-  class ObjMessage
+  /// Lane::Push() outcome
+  enum PushResult
+  {
+    PUSH_ADDED,    ///< Occupied a new slot
+    PUSH_REPLACED, ///< Replaced a waiting message, now in 'dataRef'
+    PUSH_FULL      ///< No slot available
+  };
+
+  /// One priority lane; a ring of message slots
+  class Lane
   {
   public:
-    ObjMessage(ObjMsgDataRef dataRef) { _p = dataRef; }
-    ~ObjMessage()
-    { /* ESP_LOGI(CORE_TAG, "ObjMessage destructed"); */
-    }
-    ObjMsgDataRef &dataRef() { return _p; }
+    ObjMsgDataRef *slots = NULL; ///< Message slots
+    int64_t *stamps = NULL;      ///< Send() time of each slot, for latency
+    bool *conflatable = NULL;    ///< Slot may be replaced by a newer message with the same key
+    uint16_t capacity = 0;       ///< Slots, including overflow slots
+    uint16_t head = 0;           ///< Next slot to receive
+    uint16_t count = 0;          ///< Occupied slots
+    uint8_t weight = 1;          ///< Messages per round for WEIGHTED_DRAIN
+    uint8_t credit = 0;          ///< Messages remaining this round
+    /// Given when a slot is freed, for BLOCK_OVERFLOW senders to wait on
+    SemaphoreHandle_t space = NULL;
+    ObjMsgLaneStats stats = {};
 
-  private:
-    ObjMsgDataRef _p;
+    /// Allocate 'depth' + 'spillDepth' slots, releasing any previous allocation
+    void Allocate(uint16_t depth, uint16_t spillDepth)
+    {
+      delete[] slots;
+      delete[] stamps;
+      delete[] conflatable;
+      capacity = depth + spillDepth;
+      slots = new ObjMsgDataRef[capacity];
+      stamps = new int64_t[capacity];
+      conflatable = new bool[capacity];
+      stats.depth = depth;
+      stats.spillDepth = spillDepth;
+      head = count = 0;
+      if (!space)
+      {
+        space = xSemaphoreCreateBinary();
+      }
+    }
+    /// Replace a waiting conflatable message having the same
+    /// (origin, name) as 'dataRef', leaving the replaced message in 'dataRef'.
+    /// Data named OBJMSG_NO_NAME is never replaced.
+    /// @return true if replaced
+    bool Conflate(ObjMsgDataRef &dataRef, int64_t now)
+    {
+      for (uint16_t i = 0; i < count; i++)
+      {
+        uint16_t index = (head + i) % capacity;
+        ObjMsgData *waiting = slots[index].get();
+        if (conflatable[index] && waiting->IsFrom(dataRef->GetOrigin())
+            && waiting->IsNamed(dataRef->GetNameId()))
+        {
+          slots[index].swap(dataRef);
+          stamps[index] = now;
+          ++stats.conflated;
+          return true;
+        }
+      }
+      return false;
+    }
+    /// Remove the oldest waiting message from 'origin', closing the gap
+    /// @param origin: producer whose message may be removed
+    /// @param evicted: out value, the removed message
+    /// @return true if a message was removed
+    bool Evict(uint16_t origin, ObjMsgDataRef &evicted)
+    {
+      for (uint16_t i = 0; i < count; i++)
+      {
+        uint16_t index = (head + i) % capacity;
+        if (slots[index]->IsFrom(origin))
+        {
+          evicted.swap(slots[index]);
+          // Move the older messages up one slot, keeping their order
+          for (; i > 0; i--)
+          {
+            uint16_t older = (head + i - 1) % capacity;
+            slots[index].swap(slots[older]);
+            stamps[index] = stamps[older];
+            conflatable[index] = conflatable[older];
+            index = older;
+          }
+          head = (head + 1) % capacity;
+          --count;
+          return true;
+        }
+      }
+      return false;
+    }
+    /// Place 'dataRef' in the next free slot, applying 'overflow' if full
+    ///
+    /// If 'conflate', first try to replace a waiting message with the same key
+    PushResult Push(ObjMsgDataRef &dataRef, int64_t now, bool conflate, ObjMsgOverflow overflow)
+    {
+      if (conflate && Conflate(dataRef, now))
+      {
+        ++stats.sent;
+        return PUSH_REPLACED;
+      }
+      ObjMsgDataRef evicted;
+      if (count >= stats.depth)
+      {
+        if (overflow == SPILL_OVERFLOW && count < capacity)
+        {
+          ++stats.spilled;
+        }
+        else if (overflow == DROP_OLDEST && Evict(dataRef->GetOrigin(), evicted))
+        {
+          // A producer only sheds its own backlog, so sampled data cannot
+          // push out another producer's events; it is returned in 'dataRef'
+          ++stats.evicted;
+        }
+        else
+        {
+          return PUSH_FULL;
+        }
+      }
+      uint16_t tail = (head + count) % capacity;
+      // Slot is empty (moved from by Pop), so nothing is released here
+      slots[tail].swap(dataRef);
+      stamps[tail] = now;
+      conflatable[tail] = conflate;
+      ++stats.sent;
+      if (++count > stats.highWater)
+      {
+        stats.highWater = count;
+      }
+      if (evicted)
+      {
+        dataRef.swap(evicted);
+        return PUSH_REPLACED;
+      }
+      return PUSH_ADDED;
+    }
+    /// Move the oldest slot into 'dataRef', which must be empty
+    void Pop(ObjMsgDataRef &dataRef, int64_t now)
+    {
+      dataRef.swap(slots[head]);
+      uint32_t latency = now - stamps[head];
+      stats.latencyTotalUs += latency;
+      if (latency > stats.latencyMaxUs)
+      {
+        stats.latencyMaxUs = latency;
+      }
+      ++stats.received;
+      head = (head + 1) % capacity;
+      --count;
+    }
   };
 
+  Lane lanes[PRIORITY_COUNT];
+  ObjMsgDrain drain;
+  ObjMsgOverflow overflow;  ///< Policy for Send() with DEFAULT_OVERFLOW
+  TickType_t blockTicks;    ///< Maximum wait for BLOCK_OVERFLOW
+  /// Occupied slot count, for Receive() to wait on
+  SemaphoreHandle_t pending = NULL;
+  /// Protects lane contents
+  portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+
+  /// Choose the lane to receive from; called in critical section with
+  /// at least one message waiting
+  Lane *SelectLane()
+  {
+    if (drain == WEIGHTED_DRAIN)
+    {
+      // Two passes; if no waiting lane has credit, start a new round
+      for (int pass = 0; pass < 2; pass++)
+      {
+        for (int i = 0; i < PRIORITY_COUNT; i++)
+        {
+          if (lanes[i].count && lanes[i].credit)
+          {
+            --lanes[i].credit;
+            return &lanes[i];
+          }
+        }
+        for (int i = 0; i < PRIORITY_COUNT; i++)
+        {
+          lanes[i].credit = lanes[i].weight;
+        }
+      }
+    }
+    // STRICT_DRAIN, or all waiting lanes have zero weight
+    for (int i = 0; i < PRIORITY_COUNT; i++)
+    {
+      if (lanes[i].count)
+      {
+        return &lanes[i];
+      }
+    }
+    return NULL;
+  }
+
 public:
   /// Constructor
-  /// @param message_queue_depth
-  ObjMsgTransport(uint16_t message_queue_depth)
+  ///
+  /// Each priority lane is created with 'message_queue_depth' slots, plus
+  /// MSG_SPILL_DEPTH overflow slots, and may be resized using ConfigureLane()
+  /// @param message_queue_depth: slots per lane
+  /// @param drain: lane selection for Receive()
+  ObjMsgTransport(uint16_t message_queue_depth, ObjMsgDrain drain = STRICT_DRAIN)
+      : drain(drain), overflow(DROP_NEWEST),
+        blockTicks(pdMS_TO_TICKS(MSG_OVERFLOW_BLOCK_MS))
+  {
+    for (int i = 0; i < PRIORITY_COUNT; i++)
+    {
+      lanes[i].Allocate(message_queue_depth, MSG_SPILL_DEPTH);
+      lanes[i].weight = PRIORITY_COUNT - i;
+    }
+    pending = xSemaphoreCreateCounting(UINT16_MAX, 0);
+  }
+
+  /// Set the depth, WEIGHTED_DRAIN weight and SPILL_OVERFLOW slots of the
+  /// 'priority' lane
+  ///
+  /// Must be called before messages are sent
+  /// @param priority: lane to configure
+  /// @param depth: slots in the lane
+  /// @param weight: messages per round when draining by weight
+  /// @param spillDepth: additional slots usable only by SPILL_OVERFLOW sends
+  void ConfigureLane(ObjMsgPriority priority, uint16_t depth, uint8_t weight,
+                     uint16_t spillDepth = MSG_SPILL_DEPTH)
   {
-    message_queue = xQueueCreate(message_queue_depth, sizeof(ObjMessage *));
+    lanes[priority].Allocate(depth, spillDepth);
+    lanes[priority].weight = weight;
   }
 
-  /// Create a message containing 'dataref' and send to 'message_queue'
+  /// Set the overflow policy for Send() with DEFAULT_OVERFLOW
+  /// @param overflow: policy to apply when a lane is full
+  /// @param blockMs: maximum wait for BLOCK_OVERFLOW
+  void SetOverflow(ObjMsgOverflow overflow, uint32_t blockMs = MSG_OVERFLOW_BLOCK_MS)
+  {
+    this->overflow = (overflow == DEFAULT_OVERFLOW) ? DROP_NEWEST : overflow;
+    blockTicks = pdMS_TO_TICKS(blockMs);
+  }
+
+  /// Get statistics for the 'priority' lane
+  /// @param priority: lane of interest
+  /// @param stats: out value
+  void GetLaneStats(ObjMsgPriority priority, ObjMsgLaneStats &stats)
+  {
+    portENTER_CRITICAL(&lock);
+    stats = lanes[priority].stats;
+    stats.waiting = lanes[priority].count;
+    portEXIT_CRITICAL(&lock);
+  }
+
+  /// Reset counters, high water mark and latency for all lanes
+  void ResetLaneStats()
+  {
+    portENTER_CRITICAL(&lock);
+    for (int i = 0; i < PRIORITY_COUNT; i++)
+    {
+      ObjMsgLaneStats &stats = lanes[i].stats;
+      stats.sent = stats.received = stats.dropped = stats.conflated = 0;
+      stats.evicted = stats.blocked = stats.timeouts = stats.spilled = 0;
+      stats.highWater = lanes[i].count;
+      stats.latencyMaxUs = 0;
+      stats.latencyTotalUs = 0;
+    }
+    portEXIT_CRITICAL(&lock);
+  }
+
+  /// Place 'dataref' in the next free slot of the 'priority' lane
+  ///
+  /// A 'conflate' message replaces any waiting conflatable message in the
+  /// lane with the same origin and name, so only the latest value is received.
+  ///
+  /// If the lane is full, 'overflow' determines the outcome: DROP_NEWEST
+  /// rejects 'dataRef', DROP_OLDEST discards the oldest waiting message from
+  /// the same origin (rejecting 'dataRef' if there is none),
+  /// BLOCK_OVERFLOW waits up to the transport's block time for a free slot
+  /// (do not use from the task calling Receive()), and SPILL_OVERFLOW uses
+  /// the lane's overflow slots.
   /// @param dataRef: Data to send
+  /// @param priority: lane to send on
+  /// @param conflate: replace an older waiting message with the same key
+  /// @param overflow: full lane policy; DEFAULT_OVERFLOW uses SetOverflow() policy
   /// @return boolean success
-  bool Send(ObjMsgDataRef dataRef)
+  bool Send(ObjMsgDataRef dataRef, ObjMsgPriority priority = NORMAL_PRIORITY,
+            bool conflate = false, ObjMsgOverflow overflow = DEFAULT_OVERFLOW)
   {
-    // Create message object to send shared_ptr data
-    ObjMessage *msg = new ObjMessage(dataRef);
-    // and send it
-    bool result = xQueueSend(message_queue, &msg, 0) ? true:false;
-    if (!result) {
-      ESP_LOGW("TRANSPORT", "Message Q Overflow");
-     delete msg;
+    Lane &lane = lanes[priority];
+    // Resolve topic here, on the producer's task, rather than in Forward()
+    dataRef->GetTopic();
+    if (overflow == DEFAULT_OVERFLOW)
+    {
+      overflow = this->overflow;
     }
-    return result;
+
+    TickType_t start = xTaskGetTickCount();
+    bool waited = false;
+    for (;;)
+    {
+      int64_t now = esp_timer_get_time();
+      portENTER_CRITICAL(&lock);
+      PushResult result = lane.Push(dataRef, now, conflate, overflow);
+      if (result == PUSH_FULL && overflow == BLOCK_OVERFLOW && !waited)
+      {
+        ++lane.stats.blocked;
+      }
+      portEXIT_CRITICAL(&lock);
+
+      if (result == PUSH_ADDED)
+      {
+        xSemaphoreGive(pending);
+        if (waited)
+        {
+          // Let any other blocked sender recheck for a free slot
+          xSemaphoreGive(lane.space);
+        }
+        return true;
+      }
+      if (result == PUSH_REPLACED)
+      {
+        // 'dataRef' now holds the replaced message (released on return),
+        // and no slot was added
+        return true;
+      }
+      if (overflow == BLOCK_OVERFLOW)
+      {
+        waited = true;
+        TickType_t elapsed = xTaskGetTickCount() - start;
+        if (elapsed < blockTicks && xSemaphoreTake(lane.space, blockTicks - elapsed))
+        {
+          continue;
+        }
+        portENTER_CRITICAL(&lock);
+        ++lane.stats.timeouts;
+        portEXIT_CRITICAL(&lock);
+      }
+      break;
+    }
+
+    portENTER_CRITICAL(&lock);
+    ++lane.stats.dropped;
+    portEXIT_CRITICAL(&lock);
+    ESP_LOGW("TRANSPORT", "Message Q Overflow (priority %d)", priority);
+    return false;
+  }
+
+  /// Place a shared reference to 'dataRef' in the 'priority' lane, from an ISR
+  ///
+  /// Never blocks, allocates or releases data, so 'dataRef' should be held
+  /// by its producer (for example, taken from an ObjMsgDataPool) and its
+  /// topic is resolved on Receive(). There is no conflation, and nothing is
+  /// evicted: BLOCK_OVERFLOW and SPILL_OVERFLOW use the lane's overflow
+  /// slots, other policies drop 'dataRef' if the lane is full.
+  /// @param dataRef: Data to send; shared, not moved
+  /// @param priority: lane to send on
+  /// @param overflow: full lane policy; DEFAULT_OVERFLOW uses SetOverflow() policy
+  /// @param woken: set to pdTRUE if a higher priority task was woken
+  /// @return boolean success
+  bool SendFromISR(const ObjMsgDataRef &dataRef, ObjMsgPriority priority,
+                   ObjMsgOverflow overflow, BaseType_t *woken)
+  {
+    Lane &lane = lanes[priority];
+    if (overflow == DEFAULT_OVERFLOW)
+    {
+      overflow = this->overflow;
+    }
+    if (overflow != SPILL_OVERFLOW && overflow != BLOCK_OVERFLOW)
+    {
+      overflow = DROP_NEWEST;
+    }
+    else
+    {
+      overflow = SPILL_OVERFLOW;
+    }
+
+    ObjMsgDataRef shared = dataRef;
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL_ISR(&lock);
+    PushResult result = lane.Push(shared, now, false, overflow);
+    if (result == PUSH_FULL)
+    {
+      ++lane.stats.dropped;
+    }
+    portEXIT_CRITICAL_ISR(&lock);
+
+    if (result == PUSH_ADDED)
+    {
+      xSemaphoreGiveFromISR(pending, woken);
+      return true;
+    }
+    // 'shared' is still held by the caller's 'dataRef', so is not released here
+    return false;
   }
 
   /// Add 'fwd' to the forwards list
   /// @param fwd: host to receive forwards
-  /// @return true if successful
+  /// @return true if successful, false if routing is frozen
   bool AddForward(int fromOrigin, ObjMsgHost *fwd)
   {
-    unordered_map<int, list<ObjMsgHost *>>::iterator found = forwards.find(fromOrigin);
-    if (found != forwards.end())
+    if (frozen)
     {
-      found->second.push_back(fwd);
+      ESP_LOGE("TRANSPORT", "AddForward(%d) after Freeze()", fromOrigin);
+      return false;
     }
-    else
+    forwards[fromOrigin].push_back(fwd);
+    return true;
+  }
+
+  /// Compile forwards and subscriptions into flat, contiguous tables
+  /// indexed by origin and topic ID
+  ///
+  /// Call once routing is complete (after startup). Forward() then does no
+  /// hashing or list traversal; AddForward() and Subscribe() are rejected.
+  /// Consumers are resolved here: a host is dropped from the forwards of
+  /// its own origin, and flagged if it also subscribes to a topic of that
+  /// origin, so Forward() only checks subscriptions for flagged consumers.
+  /// Each consumer's inbox or dispatcher worker, if any, is also resolved,
+  /// so Forward() hands data on without looking either up.
+  /// The data factory is not frozen here, as some hosts register their
+  /// classes after the transport is frozen; the application calls
+  /// ObjMsgData::dataFactory.Freeze() once every host has registered.
+  void Freeze()
+  {
+    if (frozen)
     {
-      list<ObjMsgHost *> fwds;
-      fwds.push_back(fwd);
-      forwards[fromOrigin] = fwds;
+      return;
     }
-    return true;
+    int maxOrigin = -1;
+    for (unordered_map<int, vector<ObjMsgHost *>>::iterator it = forwards.begin(); it != forwards.end(); ++it)
+    {
+      maxOrigin = std::max(maxOrigin, it->first);
+    }
+    flatForwards.Build(maxOrigin + 1, [this](int origin, vector<Route> &routes) {
+      unordered_map<int, vector<ObjMsgHost *>>::iterator found = forwards.find(origin);
+      if (found == forwards.end())
+      {
+        return;
+      }
+      for (ObjMsgHost *fwd : found->second)
+      {
+        if (fwd->GetOrigin() != origin)
+        {
+          routes.push_back({fwd, SubscribesFrom(fwd, origin), NULL});
+        }
+      }
+    });
+    flatSubscriptions.Build(subscriptions.size(), [this](int topic, vector<Subscriber> &subs) {
+      subs.insert(subs.end(), subscriptions[topic].begin(), subscriptions[topic].end());
+    });
+    frozen = true;
+    ResolveWorkers();
   }
 
-  /// Forward 'data' to consumers of its origin (if they are not the origin)
-  /// @param data: data to forward
-  void Forward(ObjMsgData *data)
+  /// Check if routing is frozen
+  /// @return true once Freeze() has been called
+  bool IsFrozen() { return frozen; }
+
+  /// Forward 'data' to consumers of its origin and subscribers of its
+  /// topic (if they are not the origin)
+  ///
+  /// A host that is both consumes the data once, through ConsumeTopic().
+  /// Consumers with an inbox, or all consumers if a dispatcher is set, are
+  /// posted the shared data; others consume it on the calling task
+  /// @param dataRef: data to forward
+  void Forward(const ObjMsgDataRef &dataRef)
+  {
+    ObjMsgData *data = dataRef.get();
+    uint16_t topic = data->GetTopic();
+    if (topic != OBJMSG_NO_TOPIC || !frozen)
+    {
+      ForwardChecked(dataRef, topic);
+      return;
+    }
+    // No topic subscribers, and Freeze() resolved the consumers of each origin
+    for (Route &route : flatForwards.Get(data->GetOrigin()))
+    {
+      Hand(dataRef, route.host, route.worker, NULL, false);
+    }
+  }
+
+  /// Subscribe 'fwd' to data named 'name' from 'fromOrigin'
+  ///
+  /// The (origin, name) topic is interned here, once, so Forward() dispatches
+  /// to 'fwd'->ConsumeTopic() by topic ID without a name lookup. Subscribe
+  /// during startup, before messages are received.
+  /// @param fromOrigin: origin of data
+  /// @param name: name of data
+  /// @param fwd: host to receive data
+  /// @param context: passed to 'fwd'->ConsumeTopic()
+  /// @return the topic ID, or OBJMSG_NO_TOPIC if routing is frozen or the
+  ///   name table is full
+  uint16_t Subscribe(uint16_t fromOrigin, const string &name, ObjMsgHost *fwd, void *context = NULL)
   {
-    unordered_map<int, list<ObjMsgHost *>>::iterator found = forwards.find(data->GetOrigin());
-    if (found != forwards.end())
+    if (frozen)
+    {
+      ESP_LOGE("TRANSPORT", "Subscribe(%u, %s) after Freeze()", fromOrigin, name.c_str());
+      return OBJMSG_NO_TOPIC;
+    }
+    uint16_t nameId = ObjMsgData::InternName(name);
+    if (nameId == OBJMSG_NO_NAME)
+    {
+      // Data is never named OBJMSG_NO_NAME, so the topic could not match
+      ESP_LOGE("TRANSPORT", "Subscribe(%u, %s): name table full", fromOrigin, name.c_str());
+      return OBJMSG_NO_TOPIC;
+    }
+    uint16_t topic = ObjMsgData::topicRegistry.Intern(fromOrigin, nameId);
+    if (topic >= subscriptions.size())
     {
-      for (list<ObjMsgHost *>::iterator fit = found->second.begin(); fit != found->second.end(); ++fit)
+      subscriptions.resize(topic + 1);
+    }
+    subscriptions[topic].push_back({fwd, context, NULL});
+    subscribedFrom.push_back(make_pair(fwd, fromOrigin));
+    return topic;
+  }
+
+  /// Deliver 'dataRef' to its topic subscribers (if they are not the origin)
+  /// @param dataRef: data to deliver
+  void ForwardTopic(const ObjMsgDataRef &dataRef)
+  {
+    ObjMsgData *data = dataRef.get();
+    for (Subscriber &sub : Subscribers(data->GetTopic()))
+    {
+      if (!data->IsFrom(sub.host->GetOrigin()))
       {
-        if (!data->IsFrom((*fit)->GetOrigin()))
+        Hand(dataRef, sub.host, frozen ? sub.worker : WorkerFor(sub.host), sub.context, true);
+      }
+    }
+  }
+
+  /// Run consumers on 'dispatcher' worker tasks rather than in Receive()
+  ///
+  /// Set before messages are received
+  /// @param dispatcher: dispatcher to use, or NULL to consume in Receive()
+  void SetDispatcher(ObjMsgDispatcher *dispatcher)
+  {
+    this->dispatcher = dispatcher;
+    if (frozen)
+    {
+      ResolveWorkers();
+    }
+  }
+
+  /// Check if 'data' is forwarded to 'fwd'
+  /// @param data: data to check
+  /// @param fwd: consumer to check
+  /// @return true if 'fwd' consumes 'data's origin, and is not its origin
+  bool IsForwardedTo(ObjMsgData *data, ObjMsgHost *fwd)
+  {
+    bool forwarded = false;
+    ForEachRoute(data, OBJMSG_NO_TOPIC, [fwd, &forwarded](Route &route) {
+      forwarded |= route.host == fwd;
+    });
+    return forwarded;
+  }
+
+  /// Check if 'host' subscribes to the topic of 'data'
+  /// @param data: data to check
+  /// @param host: subscriber to check
+  /// @return true if 'host' is delivered 'data' by ForwardTopic()
+  bool IsSubscribed(ObjMsgData *data, ObjMsgHost *host)
+  {
+    for (Subscriber &sub : Subscribers(data->GetTopic()))
+    {
+      if (sub.host == host)
+      {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /// Forward 'batch' to consumers, as one ConsumeBatch() per consumer
+  ///
+  /// Each consumer receives the batch members it would receive from
+  /// Forward() by origin, in order. Topic subscribers receive each member
+  /// individually through ConsumeTopic(). Consumers with an inbox or a
+  /// dispatcher worker are posted each member instead. Batches over
+  /// MSG_BATCH_MAX_DEPTH are forwarded in parts.
+  /// @param batch: data to forward
+  void ForwardBatch(span<ObjMsgDataRef> batch)
+  {
+    static_assert(MSG_BATCH_MAX_DEPTH <= 32, "batch members are a 32 bit mask");
+    if (batch.size() > MSG_BATCH_MAX_DEPTH)
+    {
+      ForwardBatch(batch.first(MSG_BATCH_MAX_DEPTH));
+      ForwardBatch(batch.subspan(MSG_BATCH_MAX_DEPTH));
+      return;
+    }
+
+    // Collect the distinct consumers once, each with a mask of its members
+    Route routes[MSG_BATCH_MAX_CONSUMERS];
+    uint32_t members[MSG_BATCH_MAX_CONSUMERS];
+    size_t routeCount = 0;
+    for (size_t i = 0; i < batch.size(); i++)
+    {
+      ObjMsgData *data = batch[i].get();
+      uint16_t topic = data->GetTopic();
+      if (topic != OBJMSG_NO_TOPIC)
+      {
+        ForwardTopic(batch[i]);
+      }
+      ForEachRoute(data, topic, [&](Route &route) {
+        size_t r = 0;
+        while (r < routeCount && routes[r].host != route.host)
+        {
+          ++r;
+        }
+        if (r == routeCount)
         {
-          (*fit)->Consume(data);
+          if (routeCount == MSG_BATCH_MAX_CONSUMERS)
+          {
+            Hand(batch[i], route.host, route.worker, NULL, false);
+            return;
+          }
+          routes[routeCount] = route;
+          members[routeCount++] = 0;
         }
-        else {
+        members[r] |= 1u << i;
+      });
+    }
+
+    ObjMsgData *group[MSG_BATCH_MAX_DEPTH];
+    for (size_t r = 0; r < routeCount; r++)
+    {
+      size_t count = 0;
+      for (size_t i = 0; i < batch.size(); i++)
+      {
+        if (!(members[r] & (1u << i)))
+        {
+          continue;
+        }
+        if (routes[r].worker)
+        {
+          Hand(batch[i], routes[r].host, routes[r].worker, NULL, false);
+        }
+        else
+        {
+          group[count++] = batch[i].get();
         }
       }
+      if (count)
+      {
+        routes[r].host->ConsumeBatch(span<ObjMsgData *>(group, count));
+      }
     }
   }
 
   /// Wait on receive queue for the next message, forward as configured and deliver to caller
   ///
+  /// Lanes are drained highest priority first (STRICT_DRAIN), or in
+  /// proportion to their weights (WEIGHTED_DRAIN)
+  ///
   /// @param dataRef: Caller's reference to receive message
   /// @param xTicksToWait: Timeout on wait
   /// @return boolean success
   bool Receive(ObjMsgDataRef &dataRef, TickType_t xTicksToWait)
   {
-    ObjMessage *msg;
-    bool result = xQueueReceive(message_queue, &msg, xTicksToWait) ? true:false;
+    bool result = xSemaphoreTake(pending, xTicksToWait) ? true : false;
     if (result)
     {
-      // Received a message. Give caller reference to its data and delete the shared_ptr message object
-      dataRef = msg->dataRef();
-      Forward(dataRef.get());
-      delete msg;
+      // Take ownership out of the slot, leaving it empty for reuse
+      ObjMsgDataRef received;
+      int64_t now = esp_timer_get_time();
+      portENTER_CRITICAL(&lock);
+      Lane *lane = SelectLane();
+      lane->Pop(received, now);
+      portEXIT_CRITICAL(&lock);
+      xSemaphoreGive(lane->space);
+
+      // Release caller's previous reference outside the critical section
+      dataRef = std::move(received);
+      Forward(dataRef);
     }
     // Return message reception result
     return result;
   }
 
+  /// Wait for the next message, then drain up to 'batch'.size() (at most
+  /// MSG_BATCH_MAX_DEPTH) waiting messages, forward them as a batch and deliver
+  /// them to caller
+  ///
+  /// Lanes are drained as for Receive()
+  ///
+  /// @param batch: Caller's references to receive messages
+  /// @param xTicksToWait: Timeout on wait for the first message
+  /// @return number of messages received
+  size_t ReceiveBatch(span<ObjMsgDataRef> batch, TickType_t xTicksToWait)
+  {
+    size_t max = std::min(batch.size(), (size_t)MSG_BATCH_MAX_DEPTH);
+    if (max == 0 || !xSemaphoreTake(pending, xTicksToWait))
+    {
+      return 0;
+    }
+    size_t count = 1;
+    while (count < max && xSemaphoreTake(pending, 0))
+    {
+      ++count;
+    }
+
+    // Take ownership out of the slots, leaving them empty for reuse
+    ObjMsgDataRef received[MSG_BATCH_MAX_DEPTH];
+    bool popped[PRIORITY_COUNT] = {};
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&lock);
+    for (size_t i = 0; i < count; i++)
+    {
+      Lane *lane = SelectLane();
+      lane->Pop(received[i], now);
+      popped[lane - lanes] = true;
+    }
+    portEXIT_CRITICAL(&lock);
+    for (int i = 0; i < PRIORITY_COUNT; i++)
+    {
+      if (popped[i])
+      {
+        xSemaphoreGive(lanes[i].space);
+      }
+    }
+
+    // Release caller's previous references outside the critical section
+    for (size_t i = 0; i < count; i++)
+    {
+      batch[i] = std::move(received[i]);
+    }
+    ForwardBatch(batch.first(count));
+    return count;
+  }
+
 protected:
-  unordered_map<int, list<ObjMsgHost *>> forwards;
+  /// Topic subscriber
+  typedef struct
+  {
+    ObjMsgHost *host;     ///< Subscribed host
+    void *context;        ///< Passed to ConsumeTopic()
+    ObjMsgWorker *worker; ///< Set by Freeze(); see Route
+  } Subscriber;
+
+  /// Consumer of an origin, as resolved by Freeze()
+  typedef struct
+  {
+    ObjMsgHost *host;     ///< Consuming host
+    bool subscriber;      ///< 'host' also subscribes to a topic of this origin
+    ObjMsgWorker *worker; ///< Worker 'host' is posted to, or NULL to consume on the receiving task
+  } Route;
+
+  /// Routing entries compiled into one contiguous array, grouped by a
+  /// dense key (origin or topic ID)
+  template <class T>
+  class FlatTable
+  {
+    vector<T> entries;      ///< All entries, grouped by key
+    vector<uint16_t> start; ///< entries[start[key] .. start[key + 1]) belong to key
+
+  public:
+    /// Build from 'keys' groups, where 'add'(key, entries) appends the
+    /// key's entries
+    template <class F>
+    void Build(size_t keys, F add)
+    {
+      entries.clear();
+      start.assign(keys + 1, 0);
+      for (size_t key = 0; key < keys; key++)
+      {
+        start[key] = entries.size();
+        add(key, entries);
+      }
+      start[keys] = entries.size();
+      entries.shrink_to_fit();
+    }
+    /// Get all entries
+    span<T> All() { return span<T>(entries); }
+    /// Get the entries for 'key'
+    span<T> Get(size_t key)
+    {
+      if (key + 1 >= start.size())
+      {
+        return span<T>();
+      }
+      return span<T>(entries.data() + start[key], start[key + 1] - start[key]);
+    }
+  };
+
+  /// Get the subscribers to 'topic'
+  /// @param topic: topic ID
+  /// @return subscribers, in Subscribe() order
+  span<Subscriber> Subscribers(uint16_t topic)
+  {
+    if (frozen)
+    {
+      return flatSubscriptions.Get(topic);
+    }
+    if (topic < subscriptions.size())
+    {
+      return span<Subscriber>(subscriptions[topic]);
+    }
+    return span<Subscriber>();
+  }
+
+  /// Check if 'host' subscribes to any topic from 'origin'
+  /// @param host: subscriber to check
+  /// @param origin: origin of the topics
+  /// @return true if 'host' has Subscribe()d to a name from 'origin'
+  bool SubscribesFrom(ObjMsgHost *host, uint16_t origin)
+  {
+    return std::find(subscribedFrom.begin(), subscribedFrom.end(), make_pair(host, origin))
+      != subscribedFrom.end();
+  }
+
+  /// Get the worker 'host' is posted to
+  /// @param host: consumer
+  /// @return the host's inbox, else its dispatcher worker, or NULL to
+  ///   consume on the receiving task
+  ObjMsgWorker *WorkerFor(ObjMsgHost *host)
+  {
+    if (host->GetInbox())
+    {
+      return host->GetInbox();
+    }
+    return dispatcher ? dispatcher->WorkerFor(host) : NULL;
+  }
+
+  /// Set the worker of each frozen route and subscriber
+  void ResolveWorkers()
+  {
+    for (Route &route : flatForwards.All())
+    {
+      route.worker = WorkerFor(route.host);
+    }
+    for (Subscriber &sub : flatSubscriptions.All())
+    {
+      sub.worker = WorkerFor(sub.host);
+    }
+  }
+
+  /// Have 'host' consume 'dataRef': post to 'worker', else consume on the
+  /// calling task
+  /// @param dataRef: data to consume; shared with the worker
+  /// @param host: consumer
+  /// @param worker: worker to post to, or NULL
+  /// @param context: ConsumeTopic() context
+  /// @param topic: use ConsumeTopic() rather than Consume()
+  void Hand(const ObjMsgDataRef &dataRef, ObjMsgHost *host, ObjMsgWorker *worker,
+            void *context, bool topic)
+  {
+    if (worker)
+    {
+      if (!worker->Post(dataRef, host, context, topic))
+      {
+        ESP_LOGW("TRANSPORT", "Worker Overflow (consumer %u)", host->GetOrigin());
+      }
+    }
+    else if (topic)
+    {
+      host->ConsumeTopic(dataRef.get(), context);
+    }
+    else
+    {
+      host->Consume(dataRef.get());
+    }
+  }
+
+  /// Forward(), checking each consumer's origin and subscriptions: before
+  /// Freeze(), or for data with topic subscribers
+  /// @param dataRef: data to forward
+  /// @param topic: topic of 'dataRef'
+  void ForwardChecked(const ObjMsgDataRef &dataRef, uint16_t topic); // Implemented in ObjMsgDataFactory.cpp
+
+  /// Call 'fn'(route) for each consumer 'data' is forwarded to by origin:
+  /// those that are not its origin, and not delivered it by ForwardTopic()
+  /// @param data: data to forward
+  /// @param topic: topic of 'data'; OBJMSG_NO_TOPIC skips the subscription check
+  /// @param fn: called with each Route
+  template <class F>
+  void ForEachRoute(ObjMsgData *data, uint16_t topic, F fn)
+  {
+    if (!frozen)
+    {
+      ForEachForward(data, topic, fn);
+      return;
+    }
+    for (Route &route : flatForwards.Get(data->GetOrigin()))
+    {
+      if (!route.subscriber || topic == OBJMSG_NO_TOPIC || !IsSubscribed(data, route.host))
+      {
+        fn(route);
+      }
+    }
+  }
+
+  /// ForEachRoute() before Freeze(), from the forwards map
+  template <class F>
+  void ForEachForward(ObjMsgData *data, uint16_t topic, F fn)
+  {
+    unordered_map<int, vector<ObjMsgHost *>>::iterator found = forwards.find(data->GetOrigin());
+    if (found == forwards.end())
+    {
+      return;
+    }
+    for (ObjMsgHost *fwd : found->second)
+    {
+      if (!data->IsFrom(fwd->GetOrigin())
+        && (topic == OBJMSG_NO_TOPIC || !IsSubscribed(data, fwd)))
+      {
+        Route route = {fwd, true, WorkerFor(fwd)};
+        fn(route);
+      }
+    }
+  }
+
+  unordered_map<int, vector<ObjMsgHost *>> forwards;
+  /// Topic subscribers, indexed by topic ID
+  vector<vector<Subscriber>> subscriptions;
+  /// (host, origin) of each Subscribe(), for Freeze() to flag routes
+  vector<pair<ObjMsgHost *, uint16_t>> subscribedFrom;
+  /// Set by Freeze(); routing uses the flat tables
+  bool frozen = false;
+  FlatTable<Route> flatForwards;
+  FlatTable<Subscriber> flatSubscriptions;
+  ObjMsgDispatcher *dispatcher = NULL;
 };
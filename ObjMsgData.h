@@ -5,7 +5,56 @@
 using namespace std;
 
 class ObjMsgData;
-typedef shared_ptr<ObjMsgData> ObjMsgDataRef;
+
+/// Counted reference to 'T' (ObjMsgData or ObjMsgBuffer)
+///
+/// The reference count is held in the object itself (intrusive), so a
+/// reference is one pointer, and moving it (as the transport does from Send()
+/// to Receive()) does no atomic operations. Copies share the object; it is
+/// deleted when the last reference is released. Source compatible with the
+/// std::shared_ptr it replaces.
+/// @tparam T: class with a std::atomic<uint32_t> 'refs' member
+template <class T>
+class ObjMsgRef
+{
+  T* data;
+
+public:
+  ObjMsgRef() : data(NULL) {}
+  ObjMsgRef(std::nullptr_t) : data(NULL) {}
+  /// Take a reference to heap allocated 'data' (from Create())
+  explicit ObjMsgRef(T* data);
+  ObjMsgRef(const ObjMsgRef& other);
+  ObjMsgRef(ObjMsgRef&& other) noexcept : data(other.data) { other.data = NULL; }
+  ~ObjMsgRef() { reset(); }
+
+  ObjMsgRef& operator=(const ObjMsgRef& other)
+  {
+    ObjMsgRef(other).swap(*this);
+    return *this;
+  }
+  ObjMsgRef& operator=(ObjMsgRef&& other) noexcept
+  {
+    ObjMsgRef(std::move(other)).swap(*this);
+    return *this;
+  }
+
+  T* get() const { return data; }
+  T* operator->() const { return data; }
+  T& operator*() const { return *data; }
+  explicit operator bool() const { return data != NULL; }
+  bool operator==(const ObjMsgRef& other) const { return data == other.data; }
+  bool operator!=(const ObjMsgRef& other) const { return data != other.data; }
+
+  /// Release the reference, deleting the data if it was the last
+  void reset();
+  void swap(ObjMsgRef& other) noexcept { std::swap(data, other.data); }
+  /// Number of references to the data (0 if empty)
+  long use_count() const;
+};
+
+/// Counted reference to ObjMsgData
+typedef ObjMsgRef<ObjMsgData> ObjMsgDataRef;
 
 /*
  *      ___       _          ___        _
@@ -15,32 +64,714 @@ typedef shared_ptr<ObjMsgData> ObjMsgDataRef;
  *                                                  |__/
  */
 
+#define OBJMSG_UNKNOWN_NAMES 8      ///< Unregistered names remembered by ObjMsgDataFactory
+#define OBJMSG_UNKNOWN_NAME_SIZE 32 ///< Longest unregistered name remembered, including NUL
+
  /// Factory to create ObjMsgDataRef from JSON data for registered data 'name'.
+ ///
+ /// Classes are registered by (origin, name) at startup, and searched in
+ /// registration order until Freeze() compiles them into a sorted two level
+ /// index, by name and then origin, searched without hashing, locking or
+ /// allocating; later registrations are rejected. A small cache of
+ /// unregistered names, such as a websocket client may send repeatedly, skips
+ /// the search and repeated logging.
 class ObjMsgDataFactory
 {
-  unordered_map<string, ObjMsgDataRef(*)(uint16_t, char const*)> dataClasses;
+public:
+  /// Create function, as registered by RegisterClass(); called with the
+  /// origin and the interned name ID
+  typedef ObjMsgDataRef (*CreateFn)(uint16_t, uint16_t);
+
+private:
+  /// A registered class; 'name' views the interned name
+  typedef struct
+  {
+    string_view name;
+    uint16_t nameId;
+    uint16_t origin;
+    CreateFn fn;
+  } Class;
+  /// The classes registered for one name: classes[first, first + count)
+  typedef struct
+  {
+    string_view name;
+    uint16_t first;
+    uint16_t count;
+  } Name;
+
+  /// By name, then in registration order, once frozen
+  vector<Class> classes;
+  /// Sorted by name, built by Freeze()
+  vector<Name> names;
+  std::atomic<bool> frozen;
+  /// Protects registration and Freeze()
+  SemaphoreHandle_t lock;
+
+  char unknown[OBJMSG_UNKNOWN_NAMES][OBJMSG_UNKNOWN_NAME_SIZE];
+  uint8_t unknownNext;
+  portMUX_TYPE unknownLock = portMUX_INITIALIZER_UNLOCKED;
+
+  bool Lookup(uint16_t origin, string_view name, Class& found);
+  bool IsUnknown(string_view name);
+  void AddUnknown(string_view name);
 
 public:
+  ObjMsgDataFactory();
+
   /// Register object creator function 'fn' to create object for endpoint 'name'
   /// @param origin - origin to register
   /// @param name - name to register
   /// @param fn - Create function
-  /// @return bool registratin successful
-  bool RegisterClass(uint16_t origin, string name, ObjMsgDataRef(*fn)(uint16_t, char const*));
+  /// @return bool registratin successful; false if (origin, name) is already
+  /// registered, the factory is frozen, or 'name' cannot be interned (the
+  /// name table is full)
+  bool RegisterClass(uint16_t origin, string name, CreateFn fn);
+
+  /// Compile registrations into the lookup index; further registrations are
+  /// rejected. Lookups never freeze.
+  ///
+  /// The application calls this once every host has registered its classes.
+  /// ObjMsgTransport::Freeze() does not, because some hosts register when
+  /// they are added, or as devices connect, after the transport is frozen
+  /// (ObsWsClientHost::Add(), ViscaHost::Add(), AvDeviceWsClientHost). Until
+  /// frozen, lookups search the registrations in order under a lock.
+  void Freeze();
+
+  /// Find the Create function for endpoint 'name' from 'origin'
+  ///
+  /// Data from an origin that did not register 'name' (such as a websocket
+  /// client) uses the first registration of 'name'.
+  /// @param origin - origin of data
+  /// @param name - registered name
+  /// @return Create function, or NULL if 'name' is not registered
+  CreateFn Find(uint16_t origin, string_view name);
 
   /// Create ObjMsgDataRef object for endpoint 'name'
   /// @param origin - origin of data
   /// @param name - registered name
-  /// @return created object
-  ObjMsgDataRef Create(uint16_t origin, char const* name);
+  /// @return created object, or NULL if 'name' is not registered
+  ObjMsgDataRef Create(uint16_t origin, string_view name);
 
   /// Create ObjMsgDataRef object and populate it based on 'json' content
+  ///
+  /// 'json' is a {"name":..., "value":...} object, split in one pass without
+  /// allocating; the value is passed to DeserializeValue(string_view). Data
+  /// for unregistered names is delivered as ObjMsgDataString, holding the
+  /// value's JSON, if the name is interned (in use locally); other names are
+  /// never interned, so untrusted input cannot fill the name table.
   /// @param origin - origin of data
   /// @param json - JSON content
-  /// @return 
-  ObjMsgDataRef Deserialize(uint16_t origin, char const* json);
+  /// @return created object, or NULL if 'json' is malformed or its name unknown
+  ObjMsgDataRef Deserialize(uint16_t origin, string_view json);
+
+  /// Create ObjMsgDataRef object and populate it from binary encoded 'data'
+  /// @param origin - origin of data
+  /// @param data - encoded content, from SerializeBinary()
+  /// @param size - number of bytes
+  /// @return created object, or NULL if the name is not registered or 'data' is malformed
+  ObjMsgDataRef DeserializeBinary(uint16_t origin, const uint8_t* data, size_t size);
+};
+
+/*
+ *      _  _
+ *     | \| |__ _ _ __  ___ ___
+ *     | .` / _` | '  \/ -_|_-<
+ *     |_|\_\__,_|_|_|_\___/__/
+ *
+ */
+
+/// Maximum distinct endpoint names
+#define OBJMSG_MAX_NAMES 256
+/// Name ID returned when the name table is full
+#define OBJMSG_NO_NAME 0xffff
+
+/// Registry of interned endpoint names
+///
+/// Each distinct name is stored once, so data carries a compact name ID and
+/// names compare as integers. Names are never removed; views returned by
+/// Name() remain valid and are NUL terminated.
+class ObjMsgNameRegistry
+{
+  unordered_map<string_view, uint16_t> ids;
+  /// Name storage; a deque, so interned strings never move
+  deque<string> names;
+  /// Views of 'names' by ID; reserved, so readers need not lock
+  vector<string_view> views;
+  /// Views published to Name(); stored after each view is written
+  std::atomic<uint16_t> published;
+  /// Protects 'ids', 'names' and 'views'
+  SemaphoreHandle_t lock;
+
+public:
+  ObjMsgNameRegistry() : published(0)
+  {
+    views.reserve(OBJMSG_MAX_NAMES);
+    lock = xSemaphoreCreateMutex();
+  }
+
+  /// Get the ID for 'name', creating it if needed
+  /// @param name - endpoint name
+  /// @return name ID, or OBJMSG_NO_NAME if the table is full
+  uint16_t Intern(string_view name);
+
+  /// Get the ID for 'name', without creating it
+  /// @param name - endpoint name
+  /// @return name ID, or OBJMSG_NO_NAME if 'name' is not interned
+  uint16_t Find(string_view name);
+
+  /// Get the name for 'id'
+  /// @param id - name ID returned by Intern()
+  /// @return name, or an empty view for OBJMSG_NO_NAME
+  string_view Name(uint16_t id)
+  {
+    return id < published.load(std::memory_order_acquire) ? views.data()[id] : string_view();
+  }
+};
+
+/*
+ *      _____         _
+ *     |_   _|__ _ __(_)__ ___
+ *       | |/ _ \ '_ \ / _(_-<
+ *       |_|\___/ .__/_\__/__/
+ *              |_|
+ */
+
+/// Topic ID of an (origin, name) with no subscriptions
+#define OBJMSG_NO_TOPIC 0xffff
+/// Topic ID not yet looked up
+#define OBJMSG_UNRESOLVED_TOPIC 0xfffe
+
+/// Registry of interned (origin, name) topic IDs
+///
+/// IDs are dense, starting at zero, so they may index subscription tables.
+/// Topics are interned at registration (startup); lookups do not allocate.
+class ObjMsgTopicRegistry
+{
+  /// Topic IDs, keyed by origin (high 16 bits) and name ID (low 16 bits)
+  unordered_map<uint32_t, uint16_t> topics;
+  uint16_t count = 0;
+
+public:
+  /// Get the topic ID for (origin, name), creating it if needed
+  /// @param origin - origin of data
+  /// @param nameId - interned data name
+  /// @return topic ID
+  uint16_t Intern(uint16_t origin, uint16_t nameId);
+
+  /// Find the topic ID for (origin, name)
+  /// @param origin - origin of data
+  /// @param nameId - interned data name
+  /// @return topic ID, or OBJMSG_NO_TOPIC if not interned
+  uint16_t Find(uint16_t origin, uint16_t nameId);
+
+  /// Number of interned topics
+  /// @return topic count
+  uint16_t Count() { return count; }
+};
+
+/*
+ *        _   _ _              _
+ *       /_\ | | |___  __ __ _| |_ ___ _ _
+ *      / _ \| | / _ \/ _/ _` |  _/ _ \ '_|
+ *     /_/ \_\_|_\___/\__\__,_|\__\___/_|
+ *
+ */
+
+/// Block pool statistics
+typedef struct
+{
+  uint32_t blockSize;  ///< Bytes per block (0 until the first allocation)
+  uint16_t capacity;   ///< Blocks reserved
+  uint16_t used;       ///< Blocks in use
+  uint16_t highWater;  ///< Maximum blocks in use
+  uint32_t allocated;  ///< Allocations served by the pool
+  uint32_t exhausted;  ///< Allocations that fell back to the heap (pool full)
+} ObjMsgPoolStats;
+
+/// Fixed size block pool, used by ObjMsgDataT and ObjMsgBuffer operator new / delete
+///
+/// Reserve() sets the block count at startup. The blocks are carved from one
+/// heap allocation on first use, sized exactly for the data class (or as
+/// reserved), and are never returned to the heap. When the pool is empty (or
+/// not reserved) allocations fall back to the heap.
+class ObjMsgBlockPool
+{
+  uint8_t* blocks = NULL;
+  void* freeList = NULL;
+  size_t reserveSize = 0;
+  ObjMsgPoolStats stats = {};
+  portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+
+  /// Carve the reserved blocks, each 'size' bytes
+  void Carve(size_t size)
+  {
+    size = (size + alignof(max_align_t) - 1) & ~(alignof(max_align_t) - 1);
+    uint8_t* storage = (uint8_t*)::operator new(size * stats.capacity);
+    void* list = NULL;
+    for (int i = stats.capacity - 1; i >= 0; i--)
+    {
+      *(void**)(storage + i * size) = list;
+      list = storage + i * size;
+    }
+    portENTER_CRITICAL(&lock);
+    if (blocks == NULL)
+    {
+      stats.blockSize = size;
+      freeList = list;
+      blocks = storage;
+      storage = NULL;
+    }
+    portEXIT_CRITICAL(&lock);
+    // Another task carved first
+    ::operator delete(storage);
+  }
+
+public:
+  /// Reserve 'count' blocks; call once, at startup
+  /// @param count: number of blocks
+  /// @param size: bytes per block, or 0 for the size of the first allocation
+  /// @return false if already reserved
+  bool Reserve(uint16_t count, size_t size = 0)
+  {
+    if (stats.capacity)
+    {
+      return false;
+    }
+    reserveSize = size;
+    stats.capacity = count;
+    return true;
+  }
+
+  /// Take a block of at least 'size' bytes from the pool
+  /// @param size: bytes required
+  /// @return the block, or NULL if the pool is empty or its blocks are too small
+  void* Take(size_t size)
+  {
+    if (stats.capacity && blocks == NULL)
+    {
+      Carve(reserveSize ? reserveSize : size);
+    }
+    void* block = NULL;
+    portENTER_CRITICAL(&lock);
+    if (freeList && size <= stats.blockSize)
+    {
+      block = freeList;
+      freeList = *(void**)block;
+      ++stats.allocated;
+      if (++stats.used > stats.highWater)
+      {
+        stats.highWater = stats.used;
+      }
+    }
+    else if (stats.capacity)
+    {
+      ++stats.exhausted;
+    }
+    portEXIT_CRITICAL(&lock);
+    return block;
+  }
+
+  /// Return a block from Take() to the pool
+  /// @param block: memory to return
+  /// @return false if 'block' is not from the pool
+  bool Give(void* block)
+  {
+    uint8_t* p = (uint8_t*)block;
+    if (blocks && p >= blocks && p < blocks + stats.capacity * stats.blockSize)
+    {
+      portENTER_CRITICAL(&lock);
+      *(void**)block = freeList;
+      freeList = block;
+      --stats.used;
+      portEXIT_CRITICAL(&lock);
+      return true;
+    }
+    return false;
+  }
+
+  /// Allocate 'size' bytes, from the pool if possible
+  /// @param size: bytes required
+  /// @return allocated memory
+  void* Allocate(size_t size)
+  {
+    void* block = Take(size);
+    return block ? block : ::operator new(size);
+  }
+
+  /// Free memory from Allocate()
+  /// @param block: memory to free
+  void Free(void* block)
+  {
+    if (!Give(block))
+    {
+      ::operator delete(block);
+    }
+  }
+
+  /// Get pool statistics
+  /// @param stats: out value
+  void GetStats(ObjMsgPoolStats& stats)
+  {
+    portENTER_CRITICAL(&lock);
+    stats = this->stats;
+    portEXIT_CRITICAL(&lock);
+  }
+};
+
+/*
+ *         _
+ *      _ | |___ ___ _ _
+ *     | || (_-</ _ \ ' \
+ *      \__//__/\___/_||_|
+ *
+ */
+
+#define OBJMSG_JSON_MAX (64 * 1024) ///< Largest JSON Serialize(string&) will produce
+
+/// JSON writer, appending to a caller provided buffer without allocating
+///
+/// The buffer is always null terminated. If the output does not fit, writing
+/// stops and Overflow() is set; retry with a larger buffer.
+class ObjMsgJsonWriter
+{
+  char* buffer;
+  size_t size;
+  size_t length;
+  bool overflow;
+
+public:
+  /// Constructor
+  /// @param buffer: buffer to write to
+  /// @param size: buffer size, including the null terminator
+  ObjMsgJsonWriter(char* buffer, size_t size)
+    : buffer(buffer), size(size), length(0), overflow(size == 0)
+  {
+    if (size)
+    {
+      buffer[0] = '\0';
+    }
+  }
+
+  /// Append 'size' characters of 'str', without quoting
+  /// @param str: characters to append
+  /// @param size: number of characters
+  void Raw(const char* str, size_t size);
+  /// Append 'str', without quoting
+  /// @param str: characters to append
+  void Raw(string_view str) { Raw(str.data(), str.size()); }
+  /// Append character 'c'
+  /// @param c: character to append
+  void Char(char c) { Raw(&c, 1); }
+  /// Append integer 'value'
+  /// @param value: value to append
+  void Int(int64_t value);
+  /// Append double 'value', in the shortest form that reads back exactly;
+  /// NaN and infinity, which JSON cannot represent, are written as null
+  /// @param value: value to append
+  void Double(double value);
+  /// Append 'str', quoted and escaped
+  /// @param str: string to append
+  void String(string_view str);
+  /// Append '"key":'
+  /// @param key: object key
+  void Key(string_view key)
+  {
+    String(key);
+    Char(':');
+  }
+
+  /// Get the unwritten part of the buffer, for writers such as cJSON_PrintPreallocated()
+  /// @param free: out value, bytes available, including the null terminator
+  /// @return pointer to the end of the output
+  char* Tail(size_t& free)
+  {
+    free = overflow ? 0 : size - length;
+    return buffer + length;
+  }
+  /// Account for 'count' characters written at Tail()
+  /// @param count: characters written, not including the null terminator
+  void Advance(size_t count) { length += count; }
+  /// Mark the output as not fitting in the buffer
+  void SetOverflow() { overflow = true; }
+
+  /// Output accessor
+  /// @return null terminated output
+  const char* c_str() { return buffer; }
+  /// Output length accessor
+  /// @return characters written, not including the null terminator
+  size_t Length() { return length; }
+  /// Check whether the output was truncated
+  /// @return true if the output did not fit
+  bool Overflow() { return overflow; }
+};
+
+/// JSON object (or array) reader, iterating the members of one object, or
+/// the elements of one array, without allocating or building a DOM
+///
+/// Keys and values are returned as spans of the input; nested objects and
+/// arrays are returned whole, for the caller to read (or pass to cJSON).
+class ObjMsgJsonReader
+{
+  string_view json;
+  size_t pos;
+  char close; ///< '}' or ']'
+  /// The closing brace or bracket was read, with only space after it
+  bool done;
+
+  void SkipSpace();
+  bool SkipString();
+  bool SkipValue();
+  bool EndValue();
+
+public:
+  /// Constructor
+  /// @param object: JSON object or array to read
+  ObjMsgJsonReader(string_view object);
+
+  /// Read the next member of an object
+  /// @param key: out value, the key, without quotes and still escaped
+  /// @param value: out value, the value's JSON
+  /// @return false at the end of the object, or if it is malformed
+  bool Next(string_view& key, string_view& value);
+
+  /// Read the next element of an array
+  /// @param value: out value, the element's JSON
+  /// @return false at the end of the array, or if it is malformed
+  bool Next(string_view& value);
+
+  /// Check that the whole object or array was read
+  /// @return true if Next() reached the closing brace or bracket
+  bool Done() { return done; }
+
+  /// Find member 'key' of 'object'
+  /// @param object: JSON object
+  /// @param key: key to find
+  /// @param value: out value, the member's JSON
+  /// @return true if found
+  static bool Member(string_view object, string_view key, string_view& value);
+
+  /// Read integer 'json'
+  /// @param json: JSON number; a fraction is truncated
+  /// @param value: out value
+  /// @return boolean success
+  static bool Int(string_view json, int64_t& value);
+  /// Read double 'json'
+  /// @param json: JSON number
+  /// @param value: out value
+  /// @return boolean success
+  static bool Double(string_view json, double& value);
+  /// Read and unescape JSON string 'json'
+  /// @param json: quoted JSON string
+  /// @param value: out value
+  /// @return boolean success
+  static bool String(string_view json, string& value);
+};
+
+/*
+ *      ___ _
+ *     | _ |_)_ _  __ _ _ _ _  _
+ *     | _ \ | ' \/ _` | '_| || |
+ *     |___/_|_||_\__,_|_|  \_, |
+ *                          |__/
+ */
+
+/// MessagePack encoder for the binary wire format, appending to 'out'
+///
+/// Encodes the subset used by ObjMsgData: arrays, integers, doubles,
+/// strings and bin (opaque bytes, for fixed layout values)
+class ObjMsgBinWriter
+{
+  vector<uint8_t>& out;
+
+  void Put(uint8_t type, uint64_t value, int bytes);
+
+public:
+  /// Constructor
+  /// @param out: buffer to append to
+  ObjMsgBinWriter(vector<uint8_t>& out) : out(out) {}
+
+  /// Start an array of 'count' items
+  /// @param count: number of items that follow
+  void Array(uint32_t count);
+  /// Write integer 'value', in the fewest bytes
+  /// @param value: value to write
+  void Int(int64_t value);
+  /// Write double 'value'
+  /// @param value: value to write
+  void Double(double value);
+  /// Write string 'str'
+  /// @param str: string to write
+  void Str(string_view str);
+  /// Write 'size' opaque bytes from 'data'
+  /// @param data: bytes to write
+  /// @param size: number of bytes
+  void Bin(const void* data, size_t size);
+};
+
+/// MessagePack decoder for the binary wire format, reading from a buffer
+///
+/// Each read returns false, without advancing, if the next item is not of
+/// the requested type or is truncated. Strings and bin are returned in place.
+class ObjMsgBinReader
+{
+  const uint8_t* pos;
+  const uint8_t* end;
+
+  bool Get(int bytes, uint64_t& value);
+
+public:
+  /// Constructor
+  /// @param data: encoded bytes
+  /// @param size: number of bytes
+  ObjMsgBinReader(const uint8_t* data, size_t size) : pos(data), end(data + size) {}
+
+  /// Read the start of an array
+  /// @param count: out value, number of items that follow
+  /// @return boolean success
+  bool Array(uint32_t& count);
+  /// Read an integer
+  /// @param value: out value
+  /// @return boolean success
+  bool Int(int64_t& value);
+  /// Read a double; integers and floats are converted
+  /// @param value: out value
+  /// @return boolean success
+  bool Double(double& value);
+  /// Read a string
+  /// @param str: out value, referencing the buffer
+  /// @return boolean success
+  bool Str(string_view& str);
+  /// Read opaque bytes
+  /// @param data: out value, referencing the buffer
+  /// @param size: out value, number of bytes
+  /// @return boolean success
+  bool Bin(const uint8_t*& data, size_t& size);
+
+  /// Number of bytes not yet read
+  /// @return count
+  size_t Remaining() { return end - pos; }
+};
+
+/*
+ *      ___       __  __
+ *     | _ )_  _ / _|/ _|___ _ _
+ *     | _ \ || |  _|  _/ -_) '_|
+ *     |___/\_,_|_| |_| \___|_|
+ *
+ */
+
+/// Encoding formats, for ObjMsgData::Encode()
+enum ObjMsgFormat
+{
+  JSON_FORMAT,   /**< Serialize() */
+  BINARY_FORMAT, /**< SerializeBinary() */
+  FORMAT_COUNT
+};
+
+/// Initial buffer size used by ObjMsgData::Encode(); larger encodings are retried
+#define OBJMSG_ENCODE_SIZE 128
+
+/// Immutable, reference counted bytes, such as the encoding of data shared by
+/// all of its consumers (see ObjMsgData::Encode())
+///
+/// The bytes are allocated with the header, in one block, and followed by a
+/// NUL so that JSON can be used as a C string. Blocks come from Pool() when
+/// it is reserved and the bytes fit, otherwise from the heap.
+class ObjMsgBuffer
+{
+  std::atomic<uint32_t> refs = 0;
+  uint32_t size;
+  uint32_t version;
+  template <class> friend class ObjMsgRef;
+
+  ObjMsgBuffer(size_t size, uint32_t version) : size(size), version(version) {}
+  static void* operator new(size_t size, size_t extra) noexcept
+  {
+    void* block = Pool().Take(size + extra);
+    return block ? block : malloc(size + extra);
+  }
+  static void operator delete(void* p)
+  {
+    if (!Pool().Give(p))
+    {
+      free(p);
+    }
+  }
+  static void operator delete(void* p, size_t) { operator delete(p); }
+
+  static ObjMsgBlockPool& Pool()
+  {
+    static ObjMsgBlockPool pool;
+    return pool;
+  }
+
+public:
+  /// Create a buffer holding a copy of 'bytes'
+  /// @param bytes: content
+  /// @param size: number of bytes
+  /// @param version: version of the data encoded
+  /// @return the buffer, or empty if out of memory
+  static ObjMsgRef<ObjMsgBuffer> Create(const void* bytes, size_t size, uint32_t version = 0)
+  {
+    ObjMsgRef<ObjMsgBuffer> buffer = Create(size, version);
+    if (buffer)
+    {
+      memcpy(buffer->Writable(), bytes, size);
+    }
+    return buffer;
+  }
+
+  /// Create a buffer of 'size' bytes, to be filled with Writable() before
+  /// it is shared
+  /// @param size: number of bytes
+  /// @param version: version of the data encoded
+  /// @return the buffer, or empty if out of memory
+  static ObjMsgRef<ObjMsgBuffer> Create(size_t size, uint32_t version = 0)
+  {
+    ObjMsgBuffer* buffer = new (size + 1) ObjMsgBuffer(size, version);
+    if (buffer)
+    {
+      ((char*)(buffer + 1))[size] = '\0';
+    }
+    return ObjMsgRef<ObjMsgBuffer>(buffer);
+  }
+
+  /// Reserve 'count' pooled buffers for up to 'size' bytes, so encoding and
+  /// broadcasting data does not use the heap; larger buffers use the heap
+  ///
+  /// Call once, at startup
+  /// @param count: number of buffers
+  /// @param size: bytes per buffer
+  /// @return false if already reserved
+  static bool ReservePool(uint16_t count, size_t size)
+  {
+    return Pool().Reserve(count, sizeof(ObjMsgBuffer) + size + 1);
+  }
+
+  /// Get pool occupancy and exhaustion
+  /// @param stats: out value
+  static void GetPoolStats(ObjMsgPoolStats& stats) { Pool().GetStats(stats); }
+
+  /// Content accessor
+  /// @return the bytes
+  const uint8_t* Data() { return (const uint8_t*)(this + 1); }
+  /// Content accessor, for filling a buffer from Create(size)
+  /// @return the bytes
+  uint8_t* Writable() { return (uint8_t*)(this + 1); }
+  /// Content accessor, for text
+  /// @return the bytes, NUL terminated
+  const char* c_str() { return (const char*)(this + 1); }
+  /// Size accessor
+  /// @return number of bytes, not including the NUL
+  size_t Size() { return size; }
+  /// Version accessor
+  /// @return version of the data encoded
+  uint32_t GetVersion() { return version; }
 };
 
+/// Counted reference to ObjMsgBuffer
+typedef ObjMsgRef<ObjMsgBuffer> ObjMsgBufferRef;
+
 /*
  *       ___  _     _ __  __         ___       _
  *      / _ \| |__ (_)  \/  |_____ _|   \ __ _| |_ __ _
@@ -49,6 +780,18 @@ public:
  *               |__/          |___/
  */
 
+/// Data type descriptor, one per data type, shared by all its instances
+///
+/// There is one type per data class D, named in its ObjMsgDataT<T, D> base,
+/// so classes sharing a value type 'T' still differ (typedefs, like
+/// ObjMsgServoData, share their type)
+typedef struct
+{
+  string tag;       ///< TAG for log messages
+  string typeName;  ///< Value type name ("T" unless RESOLVE_TYPES_FOR_LOGGING)
+  uint16_t typeId;  ///< Dense type ID, assigned on first use of the type
+} ObjMsgDataType;
+
  /// ObjMsgData virtual base class
  /// 
  /// All data is exchanged using objects of the ObjMsgData base class
@@ -57,25 +800,82 @@ public:
  /// binary data with JSON serialization and deserialization.
  /// 
  /// Abstract base class for templatized ObjMsgDataT. Intended to always be
- /// instantiated using a ObjMsgDataRef (a std::shared_ptr)
+ /// instantiated using a ObjMsgDataRef (an intrusive counted reference)
 class ObjMsgData
 {
 protected:
   /** ID of message originator */
   uint16_t origin;
-  /** Endpoint name */
-  string name;
-  string TAG;
+  /** Interned endpoint name */
+  uint16_t nameId;
+  /** Interned (origin, name) topic ID */
+  uint16_t topic = OBJMSG_UNRESOLVED_TOPIC;
+  /** Type ID, from GetType(), for checked casts without RTTI */
+  uint16_t typeId;
+  /** ObjMsgDataRef count */
+  std::atomic<uint32_t> refs = 0;
+  /** Value version, incremented by Changed(); Encode() cache validity */
+  std::atomic<uint32_t> version = 0;
+  /** Encode() cache, by ObjMsgFormat */
+  ObjMsgBufferRef encoded[FORMAT_COUNT];
+  /** Protects 'encoded' */
+  static portMUX_TYPE encodeLock;
+  template <class> friend class ObjMsgRef;
 
 public:
   static ObjMsgDataFactory dataFactory;
+  static ObjMsgNameRegistry nameRegistry;
+  static ObjMsgTopicRegistry topicRegistry;
 
-  /// Constructor
-  /// @param tag - TAG for log messages
-  ObjMsgData(string tag) : TAG(tag) { }
   /// MANDATORY vitrual destructor
   virtual ~ObjMsgData() {}
 
+  /// Type descriptor accessor
+  /// @return the descriptor shared by all data of this type
+  virtual const ObjMsgDataType& GetType() = 0;
+
+  /// TAG accessor, for log messages
+  /// @return the type's TAG
+  const char* GetTag() { return GetType().tag.c_str(); }
+
+  /// Allocate the next dense type ID
+  /// @return type ID
+  static uint16_t NextTypeId()
+  {
+    static std::atomic<uint16_t> next(0);
+    return next++;
+  }
+
+  /// Type ID accessor
+  /// @return the type ID shared by all data of this type
+  uint16_t GetTypeId() { return typeId; }
+
+  /// Check if this ObjMsgData is a 'D'
+  /// @tparam D: data class (derived from ObjMsgDataT)
+  /// @return boolean result
+  template <class D>
+  bool Is() { return typeId == D::Type().typeId; }
+
+  /// Checked cast to data class 'D'
+  /// @tparam D: data class (derived from ObjMsgDataT)
+  /// @return this as a 'D', or NULL if it is another type
+  template <class D>
+  D* As() { return Is<D>() ? static_cast<D*>(this) : NULL; }
+
+  /// Get the encoding of this data in 'format', shared by all its consumers
+  ///
+  /// The first call (by a producer, to encode eagerly, or by a consumer)
+  /// serializes; later calls share the cached buffer until the value changes.
+  /// @param format: encoding
+  /// @return the encoding, or empty if it failed
+  ObjMsgBufferRef Encode(ObjMsgFormat format); // Implemented in ObjMsgDataFactory.cpp
+
+  /// Mark the value changed, invalidating Encode() results (ISR safe)
+  ///
+  /// SetRawValue() calls this; call it after changing the value otherwise.
+  /// Data must not be changed while other references to it are in use.
+  void Changed() { version.fetch_add(1, std::memory_order_relaxed); }
+
   /// Origin ID accessor
   /// @return Origin ID
   uint16_t GetOrigin() { return origin; }
@@ -86,23 +886,67 @@ public:
   bool IsFrom(int16_t origin) { return this->origin == origin; }
 
   /// ObjMsgData name accessor 
-  /// @return the name
-  string& GetName() { return name; }
+  /// @return the name; valid for the life of the program
+  string_view GetName() { return nameRegistry.Name(nameId); }
+
+  /// Interned name accessor; equal names have equal IDs
+  /// @return the name ID
+  uint16_t GetNameId() { return nameId; }
+
+  /// Check if this ObjMsgData is named 'nameId'
+  /// @param nameId: name ID, from InternName()
+  /// @return boolean result; never true for OBJMSG_NO_NAME
+  bool IsNamed(uint16_t nameId) { return this->nameId == nameId && nameId != OBJMSG_NO_NAME; }
+
+  /// Get the ID for 'name', interning it if needed
+  /// @param name: endpoint name
+  /// @return the name ID, or OBJMSG_NO_NAME if the name table is full
+  static uint16_t InternName(string_view name) { return nameRegistry.Intern(name); }
+
+  /// Get the ID for 'name', if it is interned; for untrusted names, such as
+  /// from network clients, that must not fill the name table
+  /// @param name: endpoint name
+  /// @return the name ID, or OBJMSG_NO_NAME
+  static uint16_t FindName(string_view name) { return nameRegistry.Find(name); }
+
+  /// Topic ID accessor, looked up on first use
+  /// @return topic ID, or OBJMSG_NO_TOPIC if (origin, name) has no subscriptions
+  uint16_t GetTopic()
+  {
+    if (topic == OBJMSG_UNRESOLVED_TOPIC)
+    {
+      topic = topicRegistry.Find(origin, nameId);
+    }
+    return topic;
+  }
+
+  /// Set topic ID, for producers that have already resolved it
+  /// @param topic: the topic ID for this data's origin and name
+  void SetTopic(uint16_t topic) { this->topic = topic; }
 
   /// Create new ObjMsgDataRef by deseerializing 'json'
   /// @param origin - origin for ne object
   /// @param json: content to deserialize
   /// @return created ObjMsgDataRef
-  static ObjMsgDataRef Deserialize(uint16_t origin, char const* json) {
+  static ObjMsgDataRef Deserialize(uint16_t origin, string_view json) {
     return dataFactory.Deserialize(origin, json);
   }
 
+  /// Create new ObjMsgDataRef by deserializing binary encoded 'data'
+  /// @param origin - origin for new object
+  /// @param data: content to deserialize, from SerializeBinary()
+  /// @param size: number of bytes
+  /// @return created ObjMsgDataRef
+  static ObjMsgDataRef DeserializeBinary(uint16_t origin, const uint8_t* data, size_t size) {
+    return dataFactory.DeserializeBinary(origin, data, size);
+  }
+
   /// Register object creator function 'fn' to create object for endpoint 'name'
   /// @param origin - origin to register
   /// @param name - name to register
   /// @param fn - Create function
   /// @return bool registratin successful
-  static bool RegisterClass(uint16_t origin, string name, ObjMsgDataRef(*fn)(uint16_t, char const*))
+  static bool RegisterClass(uint16_t origin, string name, ObjMsgDataFactory::CreateFn fn)
   {
     return dataFactory.RegisterClass(origin, name, fn);
   }
@@ -112,10 +956,45 @@ public:
   /// @return boolean success
   virtual bool DeserializeValue(cJSON* json) = 0;
 
+  /// Populate value from its JSON
+  /// @param value: JSON of the value alone, from ObjMsgDataFactory::Deserialize()
+  /// @return boolean success
+  virtual bool DeserializeValue(string_view value) = 0;
+
   /// serialize this object into a JSON string
   /// @param json: out value
+  /// @return ESP_OK or error value
+  int Serialize(string& json);
+
+  /// Serialize this object as JSON into 'writer', without allocating
+  /// @param writer: writer to append to
+  /// @return false if the writer overflowed
+  bool Serialize(ObjMsgJsonWriter& writer)
+  {
+    writer.Raw("{\"name\":");
+    writer.String(GetName());
+    writer.Raw(",\"value\":");
+    SerializeValue(writer);
+    writer.Char('}');
+    return !writer.Overflow();
+  }
+
+  /// Write the value as JSON
+  /// @param writer: writer to append to
   /// @return boolean success
-  virtual int Serialize(string& json) = 0;
+  virtual bool SerializeValue(ObjMsgJsonWriter& writer) = 0;
+
+  /// Populate value from binary encoded 'reader'
+  /// @param reader: positioned at the value
+  /// @return boolean success
+  virtual bool DeserializeValueBinary(ObjMsgBinReader& reader) = 0;
+
+  /// Serialize this object, binary encoded, appending to 'out'
+  ///
+  /// The encoding is a MessagePack array of [name, value]
+  /// @param out: buffer to append to
+  /// @return ESP_OK or error value
+  virtual int SerializeBinary(vector<uint8_t>& out) = 0;
 
   /// Get value as string
   /// @param str: out value
@@ -132,6 +1011,46 @@ public:
 
 };
 
+template <class T>
+inline ObjMsgRef<T>::ObjMsgRef(T* data) : data(data)
+{
+  if (data)
+  {
+    data->refs.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+template <class T>
+inline ObjMsgRef<T>::ObjMsgRef(const ObjMsgRef& other) : data(other.data)
+{
+  if (data)
+  {
+    data->refs.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+template <class T>
+inline void ObjMsgRef<T>::reset()
+{
+  if (data)
+  {
+    // Acquire the other holders' writes before deleting; release ours
+    if (data->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+      delete data;
+    }
+  }
+  data = NULL;
+}
+
+template <class T>
+inline long ObjMsgRef<T>::use_count() const
+{
+  // Acquire, so a holder that sees itself as the last (ObjMsgDataPool::Take())
+  // also sees the released holders' writes
+  return data ? data->refs.load(std::memory_order_acquire) : 0;
+}
+
 /*
  *       ___  _     _ __  __         ___       _       _____
  *      / _ \| |__ (_)  \/  |_____ _|   \ __ _| |_ __ |_   _|
@@ -197,7 +1116,8 @@ constexpr auto type_name() -> std::string
 
 /// Templatized ObjMsgData class
 /// @tparam T: data type
-template <class T>
+/// @tparam D: the data class deriving from this, which owns the type and pool
+template <class T, class D>
 class ObjMsgDataT : public ObjMsgData
 {
 protected:
@@ -206,31 +1126,142 @@ protected:
 
   /// Constructor
   /// @param origin: data origin
-  /// @param name: data object name
+  /// @param name: data object name, interned here
   ObjMsgDataT(uint16_t origin, char const* name)
+    : ObjMsgDataT(origin, nameRegistry.Intern(name)) {}
+
+  /// Constructor, for a name already interned; no name lookup or lock
+  /// @param origin: data origin
+  /// @param nameId: name ID, from InternName()
+  ObjMsgDataT(uint16_t origin, uint16_t nameId)
+  {
+    static_assert(std::is_base_of_v<ObjMsgDataT, D>, "D must derive from ObjMsgDataT<T, D>");
+    this->origin = origin;
+    this->nameId = nameId;
+    this->typeId = Type().typeId;
+  }
+
+public:
+  /// Get the descriptor shared by all instances of D
+  /// @return type descriptor
+  static const ObjMsgDataType& Type()
+  {
 #ifdef RESOLVE_TYPES_FOR_LOGGING
-    : ObjMsgData("ObjMsgDataT<" + type_name<T>() + ">")
+    static const ObjMsgDataType type = { type_name<D>(), type_name<T>(), NextTypeId() };
 #else
-    : ObjMsgData("ObjMsgDataT<T>")
+    static const ObjMsgDataType type = { "ObjMsgDataT<T, D>", "T", NextTypeId() };
 #endif
+    return type;
+  }
+
+  const ObjMsgDataType& GetType() override { return Type(); }
+
+  /// Allocate from Pool()
+  static void* operator new(size_t size) { return Pool().Allocate(size); }
+  /// Return to Pool()
+  static void operator delete(void* p) { Pool().Free(p); }
+
+  /// Get the block pool shared by all instances of D, used by Create()
+  /// @return block pool
+  static ObjMsgBlockPool& Pool()
   {
-    this->origin = origin;
-    this->name = name;
+    static ObjMsgBlockPool pool;
+    return pool;
   }
 
-public:
+  /// Reserve 'count' pooled objects, so Create() does not use the heap
+  ///
+  /// Call once, at startup, before creating data of this type
+  /// @param count: number of objects
+  /// @return false if already reserved
+  static bool ReservePool(uint16_t count) { return Pool().Reserve(count); }
+
+  /// Get pool occupancy and exhaustion
+  /// @param stats: out value
+  static void GetPoolStats(ObjMsgPoolStats& stats) { Pool().GetStats(stats); }
+
   bool GetRawValue(T& out) { out = value; return true; }
+  bool SetRawValue(const T& in) { value = in; Changed(); return true; }
 
-  /// Serialize to JSON string
-  /// @param json: out value
-  /// @return ESP_OK or error value
-  int Serialize(string& json)
+  using ObjMsgData::DeserializeValue;
+
+  /// Populate value from its JSON, using DeserializeValue(cJSON*)
+  ///
+  /// Data classes override this to read scalars and flat objects without cJSON
+  /// @param value: JSON of the value alone
+  /// @return boolean success
+  virtual bool DeserializeValue(string_view value)
+  {
+    cJSON* parsed = cJSON_ParseWithLength(value.data(), value.size());
+    if (!parsed)
+    {
+      return false;
+    }
+    cJSON* root = cJSON_CreateObject();
+    cJSON_AddItemToObject(root, "value", parsed);
+    bool result = DeserializeValue(root);
+    cJSON_Delete(root);
+    return result;
+  }
+
+  /// Write the value as JSON, from GetValue(string&)
+  ///
+  /// Data classes override this to write without the temporary string
+  /// @param writer: writer to append to
+  /// @return boolean success
+  virtual bool SerializeValue(ObjMsgJsonWriter& writer)
   {
     string val;
-    GetValue(val);
-    json = "{\"name\":\"" + name + "\", \"value\":" + val + "}";
+    if (GetValue(val))
+    {
+      writer.Raw(val);
+      return true;
+    }
+    writer.Raw("null");
+    return false;
+  }
+
+  /// Serialize, binary encoded, appending to 'out'
+  /// @param out: buffer to append to
+  /// @return ESP_OK or error value
+  int SerializeBinary(vector<uint8_t>& out)
+  {
+    ObjMsgBinWriter writer(out);
+    writer.Array(2);
+    writer.Str(GetName());
+    return SerializeValueBinary(writer) ? 0 : -1;
+  }
+
+  /// Write the value, binary encoded
+  ///
+  /// Fixed layout (trivially copyable) values, such as joystick_sample_t,
+  /// are copied as bin in host byte order and layout, so both ends must share
+  /// the type definition. Other value types must override this.
+  /// @param writer: encoder
+  /// @return boolean success
+  virtual bool SerializeValueBinary(ObjMsgBinWriter& writer)
+  {
+    if constexpr (std::is_trivially_copyable_v<T>)
+    {
+      writer.Bin(&value, sizeof(T));
+      return true;
+    }
+    return false;
+  }
 
-    return 0;
+  bool DeserializeValueBinary(ObjMsgBinReader& reader)
+  {
+    if constexpr (std::is_trivially_copyable_v<T>)
+    {
+      const uint8_t* data;
+      size_t size;
+      if (reader.Bin(data, size) && size == sizeof(T))
+      {
+        memcpy(&value, data, sizeof(T));
+        return true;
+      }
+    }
+    return false;
   }
 
   /// MANDATORY vitrual destructor
@@ -247,7 +1278,7 @@ public:
  */
 
  /// ObjMsgDataT<int>, integer scalar value
-class ObjMsgDataInt : public ObjMsgDataT<int>
+class ObjMsgDataInt : public ObjMsgDataT<int, ObjMsgDataInt>
 {
 protected:
 public:
@@ -256,16 +1287,26 @@ public:
   /// @param name: Data object name
   /// @param value: initial value
   ObjMsgDataInt(uint16_t origin, char const* name, int value)
-    : ObjMsgDataT<int>(origin, name)
+    : ObjMsgDataT<int, ObjMsgDataInt>(origin, name)
+  {
+    this->value = value;
+    // ESP_LOGI(GetTag(), "ObjMsgDataInt(%u, %s, %d) constructed", origin, name, value);
+  }
+
+  /// Constructor, for a name already interned
+  /// @param origin: Data origin
+  /// @param nameId: Data object name ID, from InternName()
+  /// @param value: initial value
+  ObjMsgDataInt(uint16_t origin, uint16_t nameId, int value)
+    : ObjMsgDataT<int, ObjMsgDataInt>(origin, nameId)
   {
     this->value = value;
-    // ESP_LOGI(TAG.c_str(), "ObjMsgDataInt(%u, %s, %d) constructed", origin, name, value);
   }
 
   /// Destrructor
   ~ObjMsgDataInt()
   {
-    // ESP_LOGI(TAG.c_str(), "ObjMsgDataInt destructed");
+    // ESP_LOGI(GetTag(), "ObjMsgDataInt destructed");
   }
 
   /// Create object and return in ObjMsgDataRef
@@ -275,7 +1316,7 @@ public:
   /// @return created object
   static ObjMsgDataRef Create(uint16_t origin, char const* name, int value)
   {
-    return std::make_shared<ObjMsgDataInt>(origin, name, value);
+    return ObjMsgDataRef(new ObjMsgDataInt(origin, name, value));
   }
 
   /// @brief 
@@ -284,7 +1325,27 @@ public:
   /// @return created object
   static ObjMsgDataRef Create(uint16_t origin, char const* name)
   {
-    return std::make_shared<ObjMsgDataInt>(origin, name, 0);
+    return ObjMsgDataRef(new ObjMsgDataInt(origin, name, 0));
+  }
+
+  /// Create object, for a name already interned, and return in ObjMsgDataRef
+  /// @param origin: Data origin
+  /// @param nameId: Data object name ID, from InternName()
+  /// @param value: initial value
+  /// @return created object
+  static ObjMsgDataRef Create(uint16_t origin, uint16_t nameId, int value)
+  {
+    return ObjMsgDataRef(new ObjMsgDataInt(origin, nameId, value));
+  }
+
+  /// Create object, for a name already interned, as registered with the
+  /// factory
+  /// @param origin: Data origin
+  /// @param nameId: Data object name ID, from InternName()
+  /// @return created object
+  static ObjMsgDataRef Create(uint16_t origin, uint16_t nameId)
+  {
+    return ObjMsgDataRef(new ObjMsgDataInt(origin, nameId, 0));
   }
 
   bool DeserializeValue(cJSON* json)
@@ -297,6 +1358,32 @@ public:
     return false;
   }
 
+  bool DeserializeValue(string_view json)
+  {
+    int64_t tmp;
+    if (ObjMsgJsonReader::Int(json, tmp)) {
+      value = tmp;
+      return true;
+    }
+    return false;
+  }
+
+  bool SerializeValueBinary(ObjMsgBinWriter& writer)
+  {
+    writer.Int(value);
+    return true;
+  }
+
+  bool DeserializeValueBinary(ObjMsgBinReader& reader)
+  {
+    int64_t tmp;
+    if (reader.Int(tmp)) {
+      value = tmp;
+      return true;
+    }
+    return false;
+  }
+
   bool GetValue(int& val)
   {
     val = value;
@@ -310,11 +1397,18 @@ public:
   bool GetValue(string& str)
   {
     char buffer[32];
-    sprintf(buffer, "%d", value);
-    str = buffer;
+    ObjMsgJsonWriter writer(buffer, sizeof(buffer));
+    writer.Int(value);
+    str.assign(buffer, writer.Length());
 
     return true;
   }
+
+  bool SerializeValue(ObjMsgJsonWriter& writer)
+  {
+    writer.Int(value);
+    return true;
+  }
 };
 
 /*
@@ -326,7 +1420,7 @@ public:
  */
 
  // ObjMsgDataT<double>, floating point scalar value 
-class ObjMsgDataFloat : public ObjMsgDataT<double>
+class ObjMsgDataFloat : public ObjMsgDataT<double, ObjMsgDataFloat>
 {
 public:
   /// Constructor
@@ -334,16 +1428,26 @@ public:
   /// @param name: Data object name
   /// @param value: initial value
   ObjMsgDataFloat(uint16_t origin, char const* name, double value)
-    : ObjMsgDataT<double>(origin, name)
+    : ObjMsgDataT<double, ObjMsgDataFloat>(origin, name)
+  {
+    this->value = value;
+    // ESP_LOGI(GetTag(), "ObjMsgDataFloat(%u, %s, %f) constructed", origin, name, value);
+  }
+
+  /// Constructor, for a name already interned
+  /// @param origin: Data origin
+  /// @param nameId: Data object name ID, from InternName()
+  /// @param value: initial value
+  ObjMsgDataFloat(uint16_t origin, uint16_t nameId, double value)
+    : ObjMsgDataT<double, ObjMsgDataFloat>(origin, nameId)
   {
     this->value = value;
-    // ESP_LOGI(TAG.c_str(), "ObjMsgDataFloat(%u, %s, %f) constructed", origin, name, value);
   }
 
   /// Destructor
   ~ObjMsgDataFloat()
   {
-    // ESP_LOGI(TAG.c_str(), "ObjMsgDataFloat destructed");
+    // ESP_LOGI(GetTag(), "ObjMsgDataFloat destructed");
   }
 
   /// Create object and return in ObjMsgDataRef
@@ -352,7 +1456,7 @@ public:
   /// @return created object
   static ObjMsgDataRef Create(uint16_t origin, char const* name)
   {
-    return std::make_shared<ObjMsgDataFloat>(origin, name, 0);
+    return ObjMsgDataRef(new ObjMsgDataFloat(origin, name, 0));
   }
 
   /// Create object and return in ObjMsgDataRef
@@ -362,7 +1466,27 @@ public:
   /// @return created object
   static ObjMsgDataRef Create(uint16_t origin, char const* name, double value)
   {
-    return std::make_shared<ObjMsgDataFloat>(origin, name, value);
+    return ObjMsgDataRef(new ObjMsgDataFloat(origin, name, value));
+  }
+
+  /// Create object, for a name already interned, as registered with the
+  /// factory
+  /// @param origin: Data origin
+  /// @param nameId: Data object name ID, from InternName()
+  /// @return created object
+  static ObjMsgDataRef Create(uint16_t origin, uint16_t nameId)
+  {
+    return ObjMsgDataRef(new ObjMsgDataFloat(origin, nameId, 0));
+  }
+
+  /// Create object, for a name already interned, and return in ObjMsgDataRef
+  /// @param origin: Data origin
+  /// @param nameId: Data object name ID, from InternName()
+  /// @param value: initial value
+  /// @return created object
+  static ObjMsgDataRef Create(uint16_t origin, uint16_t nameId, double value)
+  {
+    return ObjMsgDataRef(new ObjMsgDataFloat(origin, nameId, value));
   }
 
   bool DeserializeValue(cJSON* json)
@@ -378,6 +1502,22 @@ public:
     return false;
   }
 
+  bool DeserializeValue(string_view json)
+  {
+    return ObjMsgJsonReader::Double(json, value);
+  }
+
+  bool SerializeValueBinary(ObjMsgBinWriter& writer)
+  {
+    writer.Double(value);
+    return true;
+  }
+
+  bool DeserializeValueBinary(ObjMsgBinReader& reader)
+  {
+    return reader.Double(value);
+  }
+
   bool GetValue(int& val)
   {
     val = value;
@@ -391,11 +1531,18 @@ public:
   bool GetValue(string& str)
   {
     char buffer[32];
-    sprintf(buffer, "%f", value);
-    str = buffer;
+    ObjMsgJsonWriter writer(buffer, sizeof(buffer));
+    writer.Double(value);
+    str.assign(buffer, writer.Length());
 
     return true;
   }
+
+  bool SerializeValue(ObjMsgJsonWriter& writer)
+  {
+    writer.Double(value);
+    return true;
+  }
 };
 
 /*
@@ -411,7 +1558,7 @@ public:
   * Note that if this is constructed with asJson = True, the
   * (presumably json) string value is serialized without quotes.
   */
-class ObjMsgDataString : public ObjMsgDataT<string>
+class ObjMsgDataString : public ObjMsgDataT<string, ObjMsgDataString>
 {
 protected:
   bool asJson;
@@ -422,15 +1569,26 @@ public:
   /// @param value: initial value
   /// @param asJson: specify JSON object value rather than string
   ObjMsgDataString(uint16_t origin, char const* name, const char* value, bool asJson = false)
-    : ObjMsgDataT<string>(origin, name), asJson(asJson)
+    : ObjMsgDataT<string, ObjMsgDataString>(origin, name), asJson(asJson)
+  {
+    this->value = value;
+    // ESP_LOGI(GetTag(), "ObjMsgDataString(%u, %s, %u) constructed", origin, name, value);
+  }
+
+  /// Constructor, for a name already interned
+  /// @param origin: Data origin
+  /// @param nameId: Data object name ID, from InternName()
+  /// @param value: initial value
+  /// @param asJson: specify JSON object value rather than string
+  ObjMsgDataString(uint16_t origin, uint16_t nameId, const char* value, bool asJson = false)
+    : ObjMsgDataT<string, ObjMsgDataString>(origin, nameId), asJson(asJson)
   {
     this->value = value;
-    // ESP_LOGI(TAG.c_str(), "ObjMsgDataString(%u, %s, %u) constructed", origin, name, value);
   }
   /// Destructor
   ~ObjMsgDataString()
   {
-    // ESP_LOGI(TAG.c_str(), "ObjMsgDataString destructed");
+    // ESP_LOGI(GetTag(), "ObjMsgDataString destructed");
   }
 
   /// Create object and return in ObjMsgDataRef
@@ -441,7 +1599,7 @@ public:
   /// @return created object
   static ObjMsgDataRef Create(uint16_t origin, char const* name, const char* value, bool asJson = false)
   {
-    return std::make_shared<ObjMsgDataString>(origin, name, value, asJson);
+    return ObjMsgDataRef(new ObjMsgDataString(origin, name, value, asJson));
   }
 
   /// Create object and return in ObjMsgDataRef
@@ -450,7 +1608,28 @@ public:
   /// @return created object
   static ObjMsgDataRef Create(uint16_t origin, char const* name)
   {
-    return std::make_shared<ObjMsgDataString>(origin, name, "");
+    return ObjMsgDataRef(new ObjMsgDataString(origin, name, ""));
+  }
+
+  /// Create object, for a name already interned, and return in ObjMsgDataRef
+  /// @param origin: Data origin
+  /// @param nameId: Data object name ID, from InternName()
+  /// @param value: initial value
+  /// @param asJson: specify JSON object value rather than string
+  /// @return created object
+  static ObjMsgDataRef Create(uint16_t origin, uint16_t nameId, const char* value, bool asJson = false)
+  {
+    return ObjMsgDataRef(new ObjMsgDataString(origin, nameId, value, asJson));
+  }
+
+  /// Create object, for a name already interned, as registered with the
+  /// factory
+  /// @param origin: Data origin
+  /// @param nameId: Data object name ID, from InternName()
+  /// @return created object
+  static ObjMsgDataRef Create(uint16_t origin, uint16_t nameId)
+  {
+    return ObjMsgDataRef(new ObjMsgDataString(origin, nameId, ""));
   }
 
   bool DeserializeValue(cJSON* json)
@@ -463,21 +1642,37 @@ public:
     return false;
   }
 
+  bool DeserializeValue(string_view json)
+  {
+    return ObjMsgJsonReader::String(json, value);
+  }
+
+  bool SerializeValueBinary(ObjMsgBinWriter& writer)
+  {
+    writer.Str(value);
+    return true;
+  }
+
+  bool DeserializeValueBinary(ObjMsgBinReader& reader)
+  {
+    string_view str;
+    if (reader.Str(str)) {
+      value = str;
+      return true;
+    }
+    return false;
+  }
+
   // Quoted value for strings
-  int Serialize(string& json)
+  bool SerializeValue(ObjMsgJsonWriter& writer)
   {
-    string val;
-    GetValue(val);
-    json = "{\"name\":\"" + name + "\", \"value\":";
     if (asJson) {
-      json += val;
+      writer.Raw(value);
     }
     else {
-      json += "\"" + val + "\"";
+      writer.String(value);
     }
-    json += " }";
-
-    return 0;
+    return true;
   }
 
   // TODO try parsing and return true if value is a number
@@ -509,7 +1704,7 @@ public:
  /** ObjMsgData<cJSON *>, JSON value
   *
   */
-class ObjMsgDataJson : public ObjMsgDataT<cJSON*>
+class ObjMsgDataJson : public ObjMsgDataT<cJSON*, ObjMsgDataJson>
 {
 public:
   /// Constructor
@@ -517,15 +1712,25 @@ public:
   /// @param name: Data object name
   /// @param value: initial value
   ObjMsgDataJson(uint16_t origin, char const* name, cJSON* value)
-    : ObjMsgDataT<cJSON*>(origin, name)
+    : ObjMsgDataT<cJSON*, ObjMsgDataJson>(origin, name)
+  {
+    this->value = value;
+    //ESP_LOGW(GetTag(), "ObjMsgDataJson(%u, %s, %p) constructed", origin, name, value);
+  }
+
+  /// Constructor, for a name already interned
+  /// @param origin: Data origin
+  /// @param nameId: Data object name ID, from InternName()
+  /// @param value: initial value
+  ObjMsgDataJson(uint16_t origin, uint16_t nameId, cJSON* value)
+    : ObjMsgDataT<cJSON*, ObjMsgDataJson>(origin, nameId)
   {
     this->value = value;
-    //ESP_LOGW(TAG.c_str(), "ObjMsgDataJson(%u, %s, %p) constructed", origin, name, value);
   }
   /// Destructor
   ~ObjMsgDataJson()
   {
-    //ESP_LOGW(TAG.c_str(), "ObjMsgDataJson %p destructed", value);
+    //ESP_LOGW(GetTag(), "ObjMsgDataJson %p destructed", value);
     if (value) {
       cJSON_Delete(value);
     }
@@ -540,12 +1745,32 @@ public:
   /// @return created object
   static ObjMsgDataRef Create(uint16_t origin, char const* name, cJSON* value = NULL)
   {
-    return std::make_shared<ObjMsgDataJson>(origin, name, value);
+    return ObjMsgDataRef(new ObjMsgDataJson(origin, name, value));
   }
 
    static ObjMsgDataRef Create(uint16_t origin, char const* name)
   {
-    return std::make_shared<ObjMsgDataJson>(origin, name, (cJSON *)NULL);
+    return ObjMsgDataRef(new ObjMsgDataJson(origin, name, (cJSON *)NULL));
+  }
+
+  /// Create object, for a name already interned, and return in ObjMsgDataRef
+  /// @param origin: Data origin
+  /// @param nameId: Data object name ID, from InternName()
+  /// @param value: initial value
+  /// @return created object
+  static ObjMsgDataRef Create(uint16_t origin, uint16_t nameId, cJSON* value)
+  {
+    return ObjMsgDataRef(new ObjMsgDataJson(origin, nameId, value));
+  }
+
+  /// Create object, for a name already interned, as registered with the
+  /// factory
+  /// @param origin: Data origin
+  /// @param nameId: Data object name ID, from InternName()
+  /// @return created object
+  static ObjMsgDataRef Create(uint16_t origin, uint16_t nameId)
+  {
+    return ObjMsgDataRef(new ObjMsgDataJson(origin, nameId, (cJSON *)NULL));
   }
 
 
@@ -561,14 +1786,50 @@ public:
     return false;
   }
 
-  int Serialize(string& json)
+  bool DeserializeValue(string_view json)
+  {
+    return DeserializeValue(cJSON_ParseWithLength(json.data(), json.size()));
+  }
+
+  /// Binary encoded as the unformatted JSON string
+  bool SerializeValueBinary(ObjMsgBinWriter& writer)
   {
-    json = "{\"name\":\"" + name + "\", \"value\":";
+    char* str = cJSON_PrintUnformatted(value);
+    if (str) {
+      writer.Str(str);
+      cJSON_free(str);
+      return true;
+    }
+    return false;
+  }
 
-    json += cJSON_Print(value);
-    json += " }";
+  bool DeserializeValueBinary(ObjMsgBinReader& reader)
+  {
+    string_view str;
+    if (reader.Str(str)) {
+      return DeserializeValue(cJSON_ParseWithLength(str.data(), str.size()));
+    }
+    return false;
+  }
 
-    return 0;
+  // Printed by cJSON directly into the writer's buffer
+  bool SerializeValue(ObjMsgJsonWriter& writer)
+  {
+    if (!value) {
+      writer.Raw("null");
+      return false;
+    }
+    size_t free;
+    char* tail = writer.Tail(free);
+    if (free && cJSON_PrintPreallocated(value, tail, (int)free, false)) {
+      writer.Advance(strlen(tail));
+      return true;
+    }
+    if (free) {
+      *tail = '\0';
+    }
+    writer.SetOverflow();
+    return false;
   }
 
   // TODO try parsing and return true if value is a number
@@ -583,12 +1844,129 @@ public:
   bool GetValue(string& str)
   {
     if (value) {
-      str = cJSON_Print(value);
-      return true;
+      char* printed = cJSON_PrintUnformatted(value);
+      if (printed) {
+        str = printed;
+        cJSON_free(printed);
+        return true;
+      }
     }
-    else {
-      return false;
+    return false;
+  }
+};
+
+
+/*
+ *      ___          _
+ *     | _ \___  ___| |
+ *     |  _/ _ \/ _ \ |
+ *     |_| \___/\___/_|
+ *
+ */
+
+/// Preallocated data objects of class 'D', all from one origin and name, for
+/// producers (such as ISRs) that must not allocate
+///
+/// The pool holds a reference to each object; an object is free when no
+/// other reference remains, so Take() never allocates or releases data.
+template <class D>
+class ObjMsgDataPool
+{
+  vector<ObjMsgDataRef> slots;
+  uint16_t next;
+  uint32_t exhausted;
+
+public:
+  /// Constructor; creates 'size' objects
+  /// @param origin: Data origin
+  /// @param name: Data object name
+  /// @param size: number of objects
+  /// @param initial: initial value
+  template <typename V>
+  ObjMsgDataPool(uint16_t origin, char const* name, uint16_t size, V initial)
+    : next(0), exhausted(0)
+  {
+    slots.reserve(size);
+    uint16_t nameId = ObjMsgData::InternName(name);
+    for (int i = 0; i < size; i++)
+    {
+      slots.push_back(D::Create(origin, nameId, initial));
     }
   }
+
+  /// Take a free object (ISR safe)
+  /// @return reference held by the pool, or NULL if all objects are in use
+  const ObjMsgDataRef* Take()
+  {
+    for (size_t i = 0; i < slots.size(); i++)
+    {
+      size_t index = (next + i) % slots.size();
+      // use_count() is an acquire load, so the last holder's reads of the
+      // object are ordered before our writes
+      if (slots[index].use_count() == 1)
+      {
+        next = (index + 1) % slots.size();
+        return &slots[index];
+      }
+    }
+    ++exhausted;
+    return NULL;
+  }
+
+  /// Get the number of failed Take() calls
+  /// @return count
+  uint32_t Exhausted() { return exhausted; }
 };
 
+/*
+ *      _____
+ *     |_   _|  _ _ __  ___ ___
+ *       | || || | '_ \/ -_|_-<
+ *       |_| \_, | .__/\___/__/
+ *           |__/|_|
+ */
+
+/// Dispatches data to the handler registered for its type, in constant time
+/// and without RTTI; a table indexed by type ID
+///
+/// Register handlers at startup, with On<D>(), then Dispatch() data as it is
+/// received. Data of unregistered types goes to the Otherwise() handler.
+class ObjMsgTypeSwitch
+{
+  typedef std::function<bool(ObjMsgData*)> Handler;
+  vector<Handler> handlers;
+  Handler otherwise;
+
+public:
+  /// Handle data of class 'D' with 'fn'
+  /// @tparam D: data class (derived from ObjMsgDataT)
+  /// @param fn: callable taking D* and returning bool
+  template <class D, class F>
+  void On(F fn)
+  {
+    uint16_t id = D::Type().typeId;
+    if (id >= handlers.size())
+    {
+      handlers.resize(id + 1);
+    }
+    handlers[id] = [fn](ObjMsgData* data) { return fn(static_cast<D*>(data)); };
+  }
+
+  /// Handle data of any type without an On() handler with 'fn'
+  /// @param fn: callable taking ObjMsgData* and returning bool
+  template <class F>
+  void Otherwise(F fn) { otherwise = fn; }
+
+  /// Call the handler for the type of 'data'
+  /// @param data: data to dispatch
+  /// @return the handler's result, or false if there is no handler
+  bool Dispatch(ObjMsgData* data)
+  {
+    uint16_t id = data->GetTypeId();
+    if (id < handlers.size() && handlers[id])
+    {
+      return handlers[id](data);
+    }
+    return otherwise ? otherwise(data) : false;
+  }
+};
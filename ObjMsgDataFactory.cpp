@@ -1,77 +1,1082 @@
 #include <stdio.h>
 #include <string.h>
+#include <charconv>
 #include <esp_log.h>
 #include "ObjMsg.h"
 
 // Constructor for static datafactory in ObjMsgData
 ObjMsgDataFactory ObjMsgData::dataFactory;
+// Constructor for static name registry in ObjMsgData
+ObjMsgNameRegistry ObjMsgData::nameRegistry;
+// Constructor for static topic registry in ObjMsgData
+ObjMsgTopicRegistry ObjMsgData::topicRegistry;
+
+// Lock for ObjMsgData Encode() caches
+portMUX_TYPE ObjMsgData::encodeLock = portMUX_INITIALIZER_UNLOCKED;
+
+/** Get the (cached) encoding of this data in 'format' */
+ObjMsgBufferRef ObjMsgData::Encode(ObjMsgFormat format)
+{
+  // The version encoded; the value must not change while it is in use
+  uint32_t current = version.load(std::memory_order_relaxed);
+  ObjMsgBufferRef buffer;
+  portENTER_CRITICAL(&encodeLock);
+  buffer = encoded[format];
+  portEXIT_CRITICAL(&encodeLock);
+  if (buffer && buffer->GetVersion() == current)
+  {
+    return buffer;
+  }
+
+  if (format == JSON_FORMAT)
+  {
+    char json[OBJMSG_ENCODE_SIZE];
+    ObjMsgJsonWriter writer(json, sizeof(json));
+    if (Serialize(writer))
+    {
+      buffer = ObjMsgBuffer::Create(json, writer.Length(), current);
+    }
+    else
+    {
+      string str;
+      if (Serialize(str) == 0)
+      {
+        buffer = ObjMsgBuffer::Create(str.data(), str.size(), current);
+      }
+    }
+  }
+  else
+  {
+    vector<uint8_t> bin;
+    bin.reserve(OBJMSG_ENCODE_SIZE);
+    if (SerializeBinary(bin) == 0)
+    {
+      buffer = ObjMsgBuffer::Create(bin.data(), bin.size(), current);
+    }
+  }
+  if (!buffer)
+  {
+    return buffer;
+  }
+
+  // Another consumer may have encoded concurrently; keep the first. The
+  // loser is released after the critical section.
+  ObjMsgBufferRef released;
+  portENTER_CRITICAL(&encodeLock);
+  if (encoded[format] && encoded[format]->GetVersion() == current)
+  {
+    released = std::move(buffer);
+    buffer = encoded[format];
+  }
+  else
+  {
+    released = std::move(encoded[format]);
+    encoded[format] = buffer;
+  }
+  portEXIT_CRITICAL(&encodeLock);
+  return buffer;
+}
 
 bool ObjMsgHost::Produce(ObjMsgDataRef data)
 {
-  return transport->Send(data);
+  return transport->Send(std::move(data), priority, conflate, overflow);
+}
+
+bool ObjMsgHost::ProduceEvent(ObjMsgDataRef data)
+{
+  return transport->Send(std::move(data), priority, false, overflow);
+}
+
+bool ObjMsgHost::SetInbox(uint16_t depth, UBaseType_t taskPriority, BaseType_t core,
+                          bool conflate, uint32_t stackSize)
+{
+  if (inbox)
+  {
+    ESP_LOGE(TAG.c_str(), "Inbox already set");
+    return false;
+  }
+  if (transport->IsFrozen())
+  {
+    // Frozen routes resolved their consumer's worker in Freeze()
+    ESP_LOGE(TAG.c_str(), "SetInbox() after Freeze()");
+    return false;
+  }
+  string name = TAG + "_inbox";
+  inbox = new ObjMsgWorker(name.c_str(), depth, taskPriority, core, stackSize, conflate);
+  return true;
+}
+
+bool ObjMsgWorker::Post(const ObjMsgDataRef &dataRef, ObjMsgHost *host, void *context, bool topic)
+{
+  ObjMsgDataRef shared = dataRef;
+  bool result = false;
+  portENTER_CRITICAL(&lock);
+  ++stats.jobs;
+  if (conflate && Conflate(shared, host, context, topic))
+  {
+    ++stats.conflated;
+    portEXIT_CRITICAL(&lock);
+    // Replaced data released here, outside the critical section
+    return true;
+  }
+  if (count < stats.depth)
+  {
+    Job &job = jobs[(head + count) % stats.depth];
+    // Slot is empty (moved from by Task), so nothing is released here
+    job.dataRef.swap(shared);
+    job.host = host;
+    job.context = context;
+    job.topic = topic;
+    if (++count > stats.highWater)
+    {
+      stats.highWater = count;
+    }
+    result = true;
+  }
+  else
+  {
+    ++stats.dropped;
+  }
+  portEXIT_CRITICAL(&lock);
+
+  if (result)
+  {
+    xSemaphoreGive(pending);
+  }
+  return result;
+}
+
+void ObjMsgTransport::ForwardChecked(const ObjMsgDataRef &dataRef, uint16_t topic)
+{
+  if (topic != OBJMSG_NO_TOPIC)
+  {
+    ForwardTopic(dataRef);
+  }
+  ForEachRoute(dataRef.get(), topic, [this, &dataRef](Route &route) {
+    Hand(dataRef, route.host, route.worker, NULL, false);
+  });
+}
+
+
+/** Get the ID for 'name', creating it if needed */
+uint16_t ObjMsgNameRegistry::Intern(string_view name)
+{
+  uint16_t id;
+  xSemaphoreTake(lock, portMAX_DELAY);
+  unordered_map<string_view, uint16_t>::iterator found = ids.find(name);
+  if (found != ids.end())
+  {
+    id = found->second;
+  }
+  else if (views.size() < OBJMSG_MAX_NAMES)
+  {
+    id = views.size();
+    names.emplace_back(name);
+    views.push_back(names.back());
+    ids[views.back()] = id;
+    // Publish the view to Name(), which reads without the lock
+    published.store(views.size(), std::memory_order_release);
+  }
+  else
+  {
+    id = OBJMSG_NO_NAME;
+  }
+  xSemaphoreGive(lock);
+  if (id == OBJMSG_NO_NAME)
+  {
+    ESP_LOGE("NAMES", "Name table full, %.*s not interned", (int)name.size(), name.data());
+  }
+  return id;
+}
+
+/** Get the ID for 'name', without creating it */
+uint16_t ObjMsgNameRegistry::Find(string_view name)
+{
+  uint16_t id = OBJMSG_NO_NAME;
+  xSemaphoreTake(lock, portMAX_DELAY);
+  unordered_map<string_view, uint16_t>::iterator found = ids.find(name);
+  if (found != ids.end())
+  {
+    id = found->second;
+  }
+  xSemaphoreGive(lock);
+  return id;
+}
+
+/** Get the topic ID for (origin, name), creating it if needed */
+uint16_t ObjMsgTopicRegistry::Intern(uint16_t origin, uint16_t nameId)
+{
+  uint16_t topic = Find(origin, nameId);
+  if (topic == OBJMSG_NO_TOPIC)
+  {
+    topic = count++;
+    topics[(uint32_t)origin << 16 | nameId] = topic;
+  }
+  return topic;
+}
+/** Find the topic ID for (origin, name) */
+uint16_t ObjMsgTopicRegistry::Find(uint16_t origin, uint16_t nameId)
+{
+  unordered_map<uint32_t, uint16_t>::iterator found = topics.find((uint32_t)origin << 16 | nameId);
+  if (found != topics.end())
+  {
+    return found->second;
+  }
+  return OBJMSG_NO_TOPIC;
+}
+
+/** Append 'size' characters of 'str', without quoting */
+void ObjMsgJsonWriter::Raw(const char* str, size_t size)
+{
+  if (overflow)
+    return;
+  if (length + size >= this->size)
+  {
+    overflow = true;
+    return;
+  }
+  memcpy(buffer + length, str, size);
+  length += size;
+  buffer[length] = '\0';
+}
+
+/** Append integer 'value' */
+void ObjMsgJsonWriter::Int(int64_t value)
+{
+  char digits[24];
+  char* end = digits + sizeof(digits);
+  char* p = end;
+  uint64_t u = value < 0 ? 0 - (uint64_t)value : value;
+  do
+  {
+    *--p = '0' + u % 10;
+    u /= 10;
+  } while (u);
+  if (value < 0)
+    *--p = '-';
+  Raw(p, end - p);
+}
+
+/** Append double 'value', shortest exact form */
+void ObjMsgJsonWriter::Double(double value)
+{
+  if (isnan(value) || value - value != 0) // NaN or infinite
+  {
+    Raw("null");
+    return;
+  }
+  char digits[32];
+  std::to_chars_result result = std::to_chars(digits, digits + sizeof(digits), value);
+  Raw(digits, result.ptr - digits);
+}
+
+/** Append 'str', quoted and escaped */
+void ObjMsgJsonWriter::String(string_view str)
+{
+  static const char hex[] = "0123456789abcdef";
+  Char('"');
+  size_t run = 0; // characters not needing escape, appended together
+  for (size_t i = 0; i < str.size(); i++)
+  {
+    unsigned char c = str[i];
+    if (c >= 0x20 && c != '"' && c != '\\')
+      continue;
+    Raw(str.data() + run, i - run);
+    run = i + 1;
+    char escape[6] = {'\\', (char)c};
+    switch (c)
+    {
+    case '"': case '\\': Raw(escape, 2); break;
+    case '\b': escape[1] = 'b'; Raw(escape, 2); break;
+    case '\f': escape[1] = 'f'; Raw(escape, 2); break;
+    case '\n': escape[1] = 'n'; Raw(escape, 2); break;
+    case '\r': escape[1] = 'r'; Raw(escape, 2); break;
+    case '\t': escape[1] = 't'; Raw(escape, 2); break;
+    default:
+      escape[1] = 'u';
+      escape[2] = '0';
+      escape[3] = '0';
+      escape[4] = hex[c >> 4];
+      escape[5] = hex[c & 0xf];
+      Raw(escape, 6);
+    }
+  }
+  Raw(str.data() + run, str.size() - run);
+  Char('"');
+}
+
+/** serialize into a JSON string; grows 'json' until the output fits */
+int ObjMsgData::Serialize(string& json)
+{
+  for (size_t size = 64; size <= OBJMSG_JSON_MAX; size *= 4)
+  {
+    json.resize(size);
+    ObjMsgJsonWriter writer(json.data(), size);
+    if (Serialize(writer))
+    {
+      json.resize(writer.Length());
+      return 0;
+    }
+  }
+  json.clear();
+  ESP_LOGE(GetTag(), "%.*s JSON larger than %u", (int)GetName().size(), GetName().data(), OBJMSG_JSON_MAX);
+  return -1;
+}
+
+/** Append 'type' followed by the low 'bytes' of 'value', big endian */
+void ObjMsgBinWriter::Put(uint8_t type, uint64_t value, int bytes)
+{
+  out.push_back(type);
+  for (int i = bytes - 1; i >= 0; i--)
+  {
+    out.push_back(value >> (8 * i));
+  }
 }
 
+/** Start an array of 'count' items */
+void ObjMsgBinWriter::Array(uint32_t count)
+{
+  if (count < 16)
+    out.push_back(0x90 | count); // fixarray
+  else if (count <= 0xffff)
+    Put(0xdc, count, 2); // array 16
+  else
+    Put(0xdd, count, 4); // array 32
+}
 
-/** register object creator function 'fn' to create object for endpoint 'name' */
-bool ObjMsgDataFactory::RegisterClass(uint16_t origin, string name, ObjMsgDataRef (*fn)(uint16_t, char const *))
+/** Write integer 'value', in the fewest bytes */
+void ObjMsgBinWriter::Int(int64_t value)
 {
-  return dataClasses.insert(make_pair(name, fn)).second;
+  if (value >= 0)
+  {
+    if (value < 128)
+      out.push_back(value); // positive fixint
+    else if (value <= 0xff)
+      Put(0xcc, value, 1); // uint 8
+    else if (value <= 0xffff)
+      Put(0xcd, value, 2); // uint 16
+    else if (value <= 0xffffffff)
+      Put(0xce, value, 4); // uint 32
+    else
+      Put(0xcf, value, 8); // uint 64
+  }
+  else
+  {
+    if (value >= -32)
+      out.push_back(value); // negative fixint
+    else if (value >= INT8_MIN)
+      Put(0xd0, value, 1); // int 8
+    else if (value >= INT16_MIN)
+      Put(0xd1, value, 2); // int 16
+    else if (value >= INT32_MIN)
+      Put(0xd2, value, 4); // int 32
+    else
+      Put(0xd3, value, 8); // int 64
+  }
+}
+
+/** Write double 'value' */
+void ObjMsgBinWriter::Double(double value)
+{
+  uint64_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  Put(0xcb, bits, 8); // float 64
+}
+
+/** Write string 'str' */
+void ObjMsgBinWriter::Str(string_view str)
+{
+  size_t size = str.size();
+  if (size < 32)
+    out.push_back(0xa0 | size); // fixstr
+  else if (size <= 0xff)
+    Put(0xd9, size, 1); // str 8
+  else if (size <= 0xffff)
+    Put(0xda, size, 2); // str 16
+  else
+    Put(0xdb, size, 4); // str 32
+  out.insert(out.end(), str.begin(), str.end());
+}
+
+/** Write 'size' opaque bytes from 'data' */
+void ObjMsgBinWriter::Bin(const void* data, size_t size)
+{
+  if (size <= 0xff)
+    Put(0xc4, size, 1); // bin 8
+  else if (size <= 0xffff)
+    Put(0xc5, size, 2); // bin 16
+  else
+    Put(0xc6, size, 4); // bin 32
+  out.insert(out.end(), (const uint8_t*)data, (const uint8_t*)data + size);
+}
+
+/** Read 'bytes' big endian bytes following the type byte at 'pos' */
+bool ObjMsgBinReader::Get(int bytes, uint64_t& value)
+{
+  if (end - pos < 1 + bytes)
+  {
+    return false;
+  }
+  value = 0;
+  for (int i = 1; i <= bytes; i++)
+  {
+    value = (value << 8) | pos[i];
+  }
+  return true;
+}
+
+/** Read the start of an array */
+bool ObjMsgBinReader::Array(uint32_t& count)
+{
+  uint64_t tmp;
+  if (pos == end)
+    return false;
+  uint8_t type = *pos;
+  if ((type & 0xf0) == 0x90)
+  {
+    count = type & 0x0f;
+    pos++;
+    return true;
+  }
+  int bytes = type == 0xdc ? 2 : type == 0xdd ? 4 : 0;
+  if (bytes && Get(bytes, tmp))
+  {
+    count = tmp;
+    pos += 1 + bytes;
+    return true;
+  }
+  return false;
+}
+
+/** Read an integer */
+bool ObjMsgBinReader::Int(int64_t& value)
+{
+  uint64_t tmp;
+  if (pos == end)
+    return false;
+  uint8_t type = *pos;
+  if (type < 0x80 || type >= 0xe0)
+  {
+    value = (int8_t)type; // positive / negative fixint
+    pos++;
+    return true;
+  }
+  int bytes;
+  switch (type)
+  {
+  case 0xcc: case 0xd0: bytes = 1; break;
+  case 0xcd: case 0xd1: bytes = 2; break;
+  case 0xce: case 0xd2: bytes = 4; break;
+  case 0xcf: case 0xd3: bytes = 8; break;
+  default: return false;
+  }
+  if (!Get(bytes, tmp))
+    return false;
+  if (type >= 0xd0)
+  { // sign extend
+    int shift = 64 - 8 * bytes;
+    value = (int64_t)(tmp << shift) >> shift;
+  }
+  else
+  {
+    value = tmp;
+  }
+  pos += 1 + bytes;
+  return true;
+}
+
+/** Read a double; integers and floats are converted */
+bool ObjMsgBinReader::Double(double& value)
+{
+  uint64_t tmp;
+  if (pos == end)
+    return false;
+  if (*pos == 0xcb && Get(8, tmp))
+  {
+    memcpy(&value, &tmp, sizeof(value));
+    pos += 9;
+    return true;
+  }
+  if (*pos == 0xca && Get(4, tmp))
+  {
+    uint32_t bits = tmp;
+    float f;
+    memcpy(&f, &bits, sizeof(f));
+    value = f;
+    pos += 5;
+    return true;
+  }
+  int64_t i;
+  if (Int(i))
+  {
+    value = i;
+    return true;
+  }
+  return false;
+}
+
+/** Read a string, referencing the buffer */
+bool ObjMsgBinReader::Str(string_view& str)
+{
+  uint64_t size;
+  int bytes;
+  if (pos == end)
+    return false;
+  uint8_t type = *pos;
+  if ((type & 0xe0) == 0xa0)
+  {
+    size = type & 0x1f;
+    bytes = 0;
+  }
+  else
+  {
+    bytes = type == 0xd9 ? 1 : type == 0xda ? 2 : type == 0xdb ? 4 : 0;
+    if (!bytes || !Get(bytes, size))
+      return false;
+  }
+  if ((uint64_t)(end - pos) < 1 + bytes + size)
+    return false;
+  str = string_view((const char*)pos + 1 + bytes, size);
+  pos += 1 + bytes + size;
+  return true;
 }
+
+/** Read opaque bytes, referencing the buffer */
+bool ObjMsgBinReader::Bin(const uint8_t*& data, size_t& size)
+{
+  uint64_t tmp;
+  if (pos == end)
+    return false;
+  uint8_t type = *pos;
+  int bytes = type == 0xc4 ? 1 : type == 0xc5 ? 2 : type == 0xc6 ? 4 : 0;
+  if (!bytes || !Get(bytes, tmp) || (uint64_t)(end - pos) < 1 + bytes + tmp)
+    return false;
+  data = pos + 1 + bytes;
+  size = tmp;
+  pos += 1 + bytes + tmp;
+  return true;
+}
+
+ObjMsgDataFactory::ObjMsgDataFactory() : frozen(false), unknownNext(0)
+{
+  lock = xSemaphoreCreateMutex();
+  memset(unknown, 0, sizeof(unknown));
+}
+
+/** register object creator function 'fn' to create object for endpoint 'name' from 'origin' */
+bool ObjMsgDataFactory::RegisterClass(uint16_t origin, string name, CreateFn fn)
+{
+  uint16_t nameId = ObjMsgData::InternName(name);
+  if (nameId == OBJMSG_NO_NAME)
+  {
+    ESP_LOGE("RegisterClass", "(%u, %s) not registered, name table full", origin, name.c_str());
+    return false;
+  }
+  bool result = false;
+  xSemaphoreTake(lock, portMAX_DELAY);
+  if (frozen)
+  {
+    ESP_LOGE("RegisterClass", "(%u, %s) after Freeze()", origin, name.c_str());
+  }
+  else
+  {
+    string_view interned = ObjMsgData::nameRegistry.Name(nameId);
+    result = std::none_of(classes.begin(), classes.end(), [&](const Class &c)
+                          { return c.origin == origin && c.name == interned; });
+    if (result)
+    {
+      classes.push_back({interned, nameId, origin, fn});
+      // The name may have been looked up, and remembered as unknown, before
+      // this registration
+      portENTER_CRITICAL(&unknownLock);
+      memset(unknown, 0, sizeof(unknown));
+      portEXIT_CRITICAL(&unknownLock);
+    }
+  }
+  xSemaphoreGive(lock);
+  return result;
+}
+
+/** Sort registrations by name and index them */
+void ObjMsgDataFactory::Freeze()
+{
+  xSemaphoreTake(lock, portMAX_DELAY);
+  if (!frozen)
+  {
+    std::stable_sort(classes.begin(), classes.end(), [](const Class &a, const Class &b)
+                     { return a.name < b.name; });
+    for (size_t i = 0; i < classes.size(); i++)
+    {
+      if (names.empty() || names.back().name != classes[i].name)
+      {
+        names.push_back({classes[i].name, (uint16_t)i, 0});
+      }
+      names.back().count++;
+    }
+    classes.shrink_to_fit();
+    names.shrink_to_fit();
+    frozen.store(true, std::memory_order_release);
+  }
+  xSemaphoreGive(lock);
+}
+
+/** Find the class registered for 'name' from 'origin' */
+bool ObjMsgDataFactory::Lookup(uint16_t origin, string_view name, Class &found)
+{
+  if (!frozen.load(std::memory_order_acquire))
+  {
+    // Hosts may still be registering; search the registrations in order
+    bool result = false;
+    xSemaphoreTake(lock, portMAX_DELAY);
+    for (size_t i = 0; i < classes.size(); i++)
+    {
+      if (classes[i].name == name && (!result || classes[i].origin == origin))
+      {
+        found = classes[i];
+        result = true;
+        if (found.origin == origin)
+        {
+          break;
+        }
+      }
+    }
+    xSemaphoreGive(lock);
+    return result;
+  }
+  vector<Name>::iterator named = std::lower_bound(names.begin(), names.end(), name, [](const Name &n, string_view name)
+                                                  { return n.name < name; });
+  if (named == names.end() || named->name != name)
+  {
+    return false;
+  }
+  found = classes[named->first];
+  for (uint16_t i = named->first; i < named->first + named->count; i++)
+  {
+    if (classes[i].origin == origin)
+    {
+      found = classes[i];
+      break;
+    }
+  }
+  return true;
+}
+
+/** Find the Create function for 'name' from 'origin' */
+ObjMsgDataFactory::CreateFn ObjMsgDataFactory::Find(uint16_t origin, string_view name)
+{
+  Class found;
+  return Lookup(origin, name, found) ? found.fn : NULL;
+}
+
+/** Check the cache of unregistered names for 'name' */
+bool ObjMsgDataFactory::IsUnknown(string_view name)
+{
+  bool found = false;
+  if (name.size() < OBJMSG_UNKNOWN_NAME_SIZE)
+  {
+    portENTER_CRITICAL(&unknownLock);
+    for (int i = 0; i < OBJMSG_UNKNOWN_NAMES && !found; i++)
+    {
+      found = strncmp(unknown[i], name.data(), name.size()) == 0 && unknown[i][name.size()] == '\0';
+    }
+    portEXIT_CRITICAL(&unknownLock);
+  }
+  return found;
+}
+
+/** Remember unregistered 'name', replacing the oldest */
+void ObjMsgDataFactory::AddUnknown(string_view name)
+{
+  if (name.size() < OBJMSG_UNKNOWN_NAME_SIZE)
+  {
+    portENTER_CRITICAL(&unknownLock);
+    memcpy(unknown[unknownNext], name.data(), name.size());
+    unknown[unknownNext][name.size()] = '\0';
+    unknownNext = (unknownNext + 1) % OBJMSG_UNKNOWN_NAMES;
+    portEXIT_CRITICAL(&unknownLock);
+  }
+}
+
 /** Create ObjMsgDataRef object for endpoint 'name' */
-ObjMsgDataRef ObjMsgDataFactory::Create(uint16_t origin, char const *name)
+ObjMsgDataRef ObjMsgDataFactory::Create(uint16_t origin, string_view name)
 {
-  ObjMsgDataRef (*fn)(uint16_t, char const *) = dataClasses[name];
-  if (fn)
-    return fn(origin, name);
+  if (IsUnknown(name))
+  {
+    return NULL;
+  }
+  Class found;
+  if (Lookup(origin, name, found))
+  {
+    // Pass the interned name ID, so creating does not look the name up again
+    return found.fn(origin, found.nameId);
+  }
+  AddUnknown(name);
+  ESP_LOGI("Create", "No class registered for: %.*s", (int)name.size(), name.data());
   return NULL;
 }
 /** Create ObjMsgDataRef object and populate it based on 'json' content */
-ObjMsgDataRef ObjMsgDataFactory::Deserialize(uint16_t origin, char const *json)
+ObjMsgDataRef ObjMsgDataFactory::Deserialize(uint16_t origin, string_view json)
 {
-  ObjMsgDataRef data = NULL;
+  ObjMsgJsonReader reader(json);
+  string_view key, item, name, value;
+  bool hasName = false, hasValue = false;
+  string unescaped;
 
-  cJSON *root = cJSON_Parse(json);
-  if (root)
+  while (reader.Next(key, item))
   {
-    cJSON *jsonName = cJSON_GetObjectItemCaseSensitive(root, "name");
-    if (jsonName)
+    if (key == "name" && item.size() >= 2 && item[0] == '"')
     {
-      data = Create(origin, cJSON_GetStringValue(jsonName));
-      if (data)
+      // Names rarely need unescaping; use the input when they do not
+      if (item.find('\\') == string_view::npos)
       {
-        if (data.get()->DeserializeValue(root))
-        {
-          cJSON_Delete(root);
-          return data;
-        }
-        else
+        name = item.substr(1, item.size() - 2);
+        hasName = true;
+      }
+      else if (ObjMsgJsonReader::String(item, unescaped))
+      {
+        name = unescaped;
+        hasName = true;
+      }
+    }
+    else if (key == "value")
+    {
+      value = item;
+      hasValue = true;
+    }
+  }
+  if (!reader.Done() || !hasValue)
+  {
+    ESP_LOGE("Deserialize", "JSON malformed: %.*s", (int)json.size(), json.data());
+    return NULL;
+  }
+  if (!hasName)
+  {
+    ESP_LOGE("Deserialize", "JSON has no name field: %.*s", (int)json.size(), json.data());
+    return NULL;
+  }
+
+  ObjMsgDataRef data = Create(origin, name);
+  if (data)
+  {
+    if (data->DeserializeValue(value))
+    {
+      return data;
+    }
+    ESP_LOGE("Deserialize", "Unable to parse value: %.*s", (int)json.size(), json.data());
+    return NULL;
+  }
+  // If not registered, deliver as JSON object carried in string. The name may
+  // come from a network client, so only names already interned are carried;
+  // interning it would let clients fill the name table
+  uint16_t nameId = ObjMsgData::FindName(name);
+  if (nameId == OBJMSG_NO_NAME)
+  {
+    ESP_LOGD("Deserialize", "Dropped, name not interned: %.*s", (int)name.size(), name.data());
+    return NULL;
+  }
+  return ObjMsgDataString::Create(origin, nameId, string(value).c_str(), true);
+}
+
+/*
+ * ObjMsgJsonReader
+ */
+
+/** Position at the first member or element; anything else reads as malformed */
+ObjMsgJsonReader::ObjMsgJsonReader(string_view object) : json(object), pos(0), close('}'), done(false)
+{
+  SkipSpace();
+  if (pos < json.size() && (json[pos] == '{' || json[pos] == '['))
+  {
+    close = json[pos] == '{' ? '}' : ']';
+    pos++;
+  }
+  else
+  {
+    pos = string_view::npos;
+  }
+}
+
+void ObjMsgJsonReader::SkipSpace()
+{
+  while (pos < json.size() && (json[pos] == ' ' || json[pos] == '\t' || json[pos] == '\n' || json[pos] == '\r'))
+  {
+    pos++;
+  }
+}
+
+/** Skip the string at 'pos', including its quotes */
+bool ObjMsgJsonReader::SkipString()
+{
+  if (pos >= json.size() || json[pos] != '"')
+    return false;
+  for (pos++; pos < json.size(); pos++)
+  {
+    if (json[pos] == '\\')
+    {
+      pos++;
+    }
+    else if (json[pos] == '"')
+    {
+      pos++;
+      return true;
+    }
+  }
+  return false;
+}
+
+/** Skip the value at 'pos'; nested objects and arrays by bracket depth */
+bool ObjMsgJsonReader::SkipValue()
+{
+  if (pos >= json.size())
+    return false;
+  char c = json[pos];
+  if (c == '"')
+    return SkipString();
+  if (c == '{' || c == '[')
+  {
+    int depth = 0;
+    while (pos < json.size())
+    {
+      c = json[pos];
+      if (c == '"')
+      {
+        if (!SkipString())
+          return false;
+        continue;
+      }
+      if (c == '{' || c == '[')
+        depth++;
+      else if ((c == '}' || c == ']') && --depth == 0)
+      {
+        pos++;
+        return true;
+      }
+      pos++;
+    }
+    return false;
+  }
+  // Number or literal; ends at the next separator
+  size_t start = pos;
+  while (pos < json.size() && json[pos] != ',' && json[pos] != '}' && json[pos] != ']' &&
+         json[pos] != ' ' && json[pos] != '\t' && json[pos] != '\n' && json[pos] != '\r')
+  {
+    pos++;
+  }
+  return pos > start;
+}
+
+/** At the end of the object or array, check only trailing space follows */
+bool ObjMsgJsonReader::EndValue()
+{
+  SkipSpace();
+  if (pos < json.size() && json[pos] == close)
+  {
+    pos++;
+    SkipSpace();
+    done = pos == json.size();
+    if (!done)
+      pos = string_view::npos;
+    return true;
+  }
+  return false;
+}
+
+/** Read the next member */
+bool ObjMsgJsonReader::Next(string_view& key, string_view& value)
+{
+  if (done || pos >= json.size() || close != '}' || EndValue())
+    return false; // Read to the end, malformed, or truncated before the '}'
+  size_t start = pos;
+  if (!SkipString())
+  {
+    pos = string_view::npos;
+    return false;
+  }
+  key = json.substr(start + 1, pos - start - 2);
+  SkipSpace();
+  if (pos >= json.size() || json[pos] != ':')
+  {
+    pos = string_view::npos;
+    return false;
+  }
+  pos++;
+  SkipSpace();
+  start = pos;
+  if (!SkipValue())
+  {
+    pos = string_view::npos;
+    return false;
+  }
+  value = json.substr(start, pos - start);
+  SkipSpace();
+  if (pos < json.size() && json[pos] == ',')
+  {
+    pos++;
+  }
+  else if (pos >= json.size() || json[pos] != close)
+  {
+    pos = string_view::npos;
+    return false;
+  }
+  return true;
+}
+
+/** Read the next element */
+bool ObjMsgJsonReader::Next(string_view& value)
+{
+  if (done || pos >= json.size() || close != ']' || EndValue())
+    return false; // Read to the end, malformed, or truncated before the ']'
+  size_t start = pos;
+  if (!SkipValue())
+  {
+    pos = string_view::npos;
+    return false;
+  }
+  value = json.substr(start, pos - start);
+  SkipSpace();
+  if (pos < json.size() && json[pos] == ',')
+  {
+    pos++;
+  }
+  else if (pos >= json.size() || json[pos] != close)
+  {
+    pos = string_view::npos;
+    return false;
+  }
+  return true;
+}
+
+/** Find member 'key' of 'object' */
+bool ObjMsgJsonReader::Member(string_view object, string_view key, string_view& value)
+{
+  ObjMsgJsonReader reader(object);
+  string_view found;
+  while (reader.Next(found, value))
+  {
+    if (found == key)
+      return true;
+  }
+  return false;
+}
+
+/** Read integer 'json'; a fraction is truncated */
+bool ObjMsgJsonReader::Int(string_view json, int64_t& value)
+{
+  const char* end = json.data() + json.size();
+  std::from_chars_result result = std::from_chars(json.data(), end, value);
+  if (result.ec != std::errc())
+    return false;
+  if (result.ptr != end)
+  { // Fraction or exponent
+    double tmp;
+    if (!Double(json, tmp) || !(tmp >= INT64_MIN && tmp < 9.3e18))
+      return false;
+    value = (int64_t)tmp;
+  }
+  return true;
+}
+
+/** Read double 'json' */
+bool ObjMsgJsonReader::Double(string_view json, double& value)
+{
+  const char* end = json.data() + json.size();
+  std::from_chars_result result = std::from_chars(json.data(), end, value);
+  return result.ec == std::errc() && result.ptr == end;
+}
+
+/** Read and unescape JSON string 'json' */
+bool ObjMsgJsonReader::String(string_view json, string& value)
+{
+  if (json.size() < 2 || json.front() != '"' || json.back() != '"')
+    return false;
+  json = json.substr(1, json.size() - 2);
+  value.clear();
+  size_t run = 0; // characters not needing unescape, copied together
+  for (size_t i = 0; i < json.size(); i++)
+  {
+    if (json[i] != '\\')
+      continue;
+    value.append(json.data() + run, i - run);
+    if (++i >= json.size())
+      return false;
+    switch (json[i])
+    {
+    case 'b': value += '\b'; break;
+    case 'f': value += '\f'; break;
+    case 'n': value += '\n'; break;
+    case 'r': value += '\r'; break;
+    case 't': value += '\t'; break;
+    case 'u':
+    {
+      uint32_t code;
+      std::from_chars_result result = std::from_chars(json.data() + i + 1, json.data() + std::min(i + 5, json.size()), code, 16);
+      if (result.ptr != json.data() + i + 5)
+        return false;
+      i += 4;
+      // Combine a surrogate pair
+      if (code >= 0xd800 && code < 0xdc00 && i + 6 < json.size() && json[i + 1] == '\\' && json[i + 2] == 'u')
+      {
+        uint32_t low;
+        result = std::from_chars(json.data() + i + 3, json.data() + i + 7, low, 16);
+        if (result.ptr == json.data() + i + 7 && low >= 0xdc00 && low < 0xe000)
         {
-          ESP_LOGE("Deserialize", "Unable to parse value: %s", json);
+          code = 0x10000 + ((code - 0xd800) << 10) + (low - 0xdc00);
+          i += 6;
         }
       }
+      // Encode as UTF-8
+      if (code < 0x80)
+        value += (char)code;
+      else if (code < 0x800)
+      {
+        value += (char)(0xc0 | code >> 6);
+        value += (char)(0x80 | (code & 0x3f));
+      }
+      else if (code < 0x10000)
+      {
+        value += (char)(0xe0 | code >> 12);
+        value += (char)(0x80 | (code >> 6 & 0x3f));
+        value += (char)(0x80 | (code & 0x3f));
+      }
       else
       {
-        //printf("Create(%d, %s, %s)\n", origin, cJSON_GetStringValue(jsonName),
-        //       cJSON_Print(cJSON_GetObjectItem(root, "value")));
-        // If not registered, deliver as JSON object carried in string
-        data = ObjMsgDataString::Create(origin, cJSON_GetStringValue(jsonName),
-                                        cJSON_Print(cJSON_GetObjectItem(root, "value")), true);
-        ESP_LOGI("Deserialize", "No class registered for: %s", cJSON_GetStringValue(jsonName));
-
-        cJSON_Delete(root);
-        return data;
+        value += (char)(0xf0 | code >> 18);
+        value += (char)(0x80 | (code >> 12 & 0x3f));
+        value += (char)(0x80 | (code >> 6 & 0x3f));
+        value += (char)(0x80 | (code & 0x3f));
       }
+      break;
     }
-    else
+    default: value += json[i]; // '"', '\\' and '/'
+    }
+    run = i + 1;
+  }
+  value.append(json.data() + run, json.size() - run);
+  return true;
+}
+
+/** Create ObjMsgDataRef object and populate it from binary encoded 'data' */
+ObjMsgDataRef ObjMsgDataFactory::DeserializeBinary(uint16_t origin, const uint8_t* data, size_t size)
+{
+  ObjMsgBinReader reader(data, size);
+  uint32_t count;
+  string_view name;
+
+  if (reader.Array(count) && count == 2 && reader.Str(name))
+  {
+    ObjMsgDataRef obj = Create(origin, name);
+    if (obj)
     {
-      ESP_LOGE("Deserialize", "JSON has no name field: %s", json);
+      if (obj->DeserializeValueBinary(reader))
+      {
+        return obj;
+      }
+      ESP_LOGE("DeserializeBinary", "Unable to decode value for: %.*s", (int)name.size(), name.data());
     }
-    cJSON_Delete(root);
   }
   else
   {
-    ESP_LOGE("Deserialize", "JSON malformed: %s", json);
+    ESP_LOGE("DeserializeBinary", "Malformed binary data (%u bytes)", (unsigned)size);
   }
-
   return NULL;
 }
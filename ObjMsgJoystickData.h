@@ -19,7 +19,7 @@ typedef struct
 } joystick_sample_t;
 
 // ObjMsgDataT<joystick_sample_t>,  with joystick data structure value
-class ObjMsgJoystickData : public ObjMsgDataT<joystick_sample_t>
+class ObjMsgJoystickData : public ObjMsgDataT<joystick_sample_t, ObjMsgJoystickData>
 {
 public:
   /// Constructor
@@ -27,21 +27,35 @@ public:
   /// @param name: Data object name
   /// @param value: initial value
   ObjMsgJoystickData(uint16_t origin, char const *name, joystick_sample_t value)
-      : ObjMsgDataT<joystick_sample_t>(origin, name)
+      : ObjMsgDataT<joystick_sample_t, ObjMsgJoystickData>(origin, name)
   {
     this->value = value;
-    // ESP_LOGI(TAG.c_str(), "ObjMsgJoystickData(%u, %s, %u) constructed", origin, name, value);
+    // ESP_LOGI(GetTag(), "ObjMsgJoystickData(%u, %s, %u) constructed", origin, name, value);
   }
   /// Constructor without initial value
   /// @param origin: Data origin
   /// @param name: Data object name
   ObjMsgJoystickData(uint16_t origin, char const *name)
-      : ObjMsgDataT<joystick_sample_t>(origin, name) {}
+      : ObjMsgDataT<joystick_sample_t, ObjMsgJoystickData>(origin, name) {}
+  /// Constructor, for a name already interned
+  /// @param origin: Data origin
+  /// @param nameId: Data object name ID, from InternName()
+  /// @param value: initial value
+  ObjMsgJoystickData(uint16_t origin, uint16_t nameId, joystick_sample_t value)
+      : ObjMsgDataT<joystick_sample_t, ObjMsgJoystickData>(origin, nameId)
+  {
+    this->value = value;
+  }
+  /// Constructor, for a name already interned, without initial value
+  /// @param origin: Data origin
+  /// @param nameId: Data object name ID, from InternName()
+  ObjMsgJoystickData(uint16_t origin, uint16_t nameId)
+      : ObjMsgDataT<joystick_sample_t, ObjMsgJoystickData>(origin, nameId) {}
 
   /// Destructor
   ~ObjMsgJoystickData()
   {
-    // ESP_LOGI(TAG.c_str(), "ObjMsgJoystickData destructed");
+    // ESP_LOGI(GetTag(), "ObjMsgJoystickData destructed");
   }
 
   /// Create object and return in ObjMsgDataRef
@@ -51,7 +65,7 @@ public:
   /// @return created object
   static ObjMsgDataRef Create(uint16_t origin, char const *name, joystick_sample_t value)
   {
-    return std::make_shared<ObjMsgJoystickData>(origin, name, value);
+    return ObjMsgDataRef(new ObjMsgJoystickData(origin, name, value));
   }
 
   /// Create object and return in ObjMsgDataRef
@@ -60,7 +74,27 @@ public:
   /// @return created object
   static ObjMsgDataRef Create(uint16_t origin, char const *name)
   {
-    return std::make_shared<ObjMsgJoystickData>(origin, name);
+    return ObjMsgDataRef(new ObjMsgJoystickData(origin, name));
+  }
+
+  /// Create object, for a name already interned, and return in ObjMsgDataRef
+  /// @param origin: Data origin
+  /// @param nameId: Data object name ID, from InternName()
+  /// @param value: initial value
+  /// @return created object
+  static ObjMsgDataRef Create(uint16_t origin, uint16_t nameId, joystick_sample_t value)
+  {
+    return ObjMsgDataRef(new ObjMsgJoystickData(origin, nameId, value));
+  }
+
+  /// Create object, for a name already interned, as registered with the
+  /// factory
+  /// @param origin: Data origin
+  /// @param nameId: Data object name ID, from InternName()
+  /// @return created object
+  static ObjMsgDataRef Create(uint16_t origin, uint16_t nameId)
+  {
+    return ObjMsgDataRef(new ObjMsgJoystickData(origin, nameId));
   }
 
   bool DeserializeValue(cJSON *json)
@@ -72,6 +106,38 @@ public:
     return true;
   }
 
+  /// Read the flat {"x":..} object without cJSON
+  bool DeserializeValue(string_view json)
+  {
+    ObjMsgJsonReader reader(json);
+    string_view key, item;
+    int64_t tmp;
+    int found = 0;
+    while (reader.Next(key, item))
+    {
+      if (!ObjMsgJsonReader::Int(item, tmp))
+      {
+        return false;
+      }
+      if (key == "x")
+      {
+        value.x = tmp;
+        found |= 1;
+      }
+      else if (key == "y")
+      {
+        value.y = tmp;
+        found |= 2;
+      }
+      else if (key == "up")
+      {
+        value.up = tmp;
+        found |= 4;
+      }
+    }
+    return reader.Done() && found == 7;
+  }
+
   bool GetValue(int &val)
   {
     // val = value;
@@ -85,10 +151,22 @@ public:
   bool GetValue(string &str)
   {
     char buffer[80];
-    sprintf(buffer, " { \"x\":%d, \"y\":%d, \"up\":%d }",
-            value.x, value.y, value.up);
-    str = buffer;
+    ObjMsgJsonWriter writer(buffer, sizeof(buffer));
+    SerializeValue(writer);
+    str.assign(buffer, writer.Length());
+
+    return true;
+  }
 
+  bool SerializeValue(ObjMsgJsonWriter &writer)
+  {
+    writer.Raw("{\"x\":");
+    writer.Int(value.x);
+    writer.Raw(",\"y\":");
+    writer.Int(value.y);
+    writer.Raw(",\"up\":");
+    writer.Int(value.up);
+    writer.Char('}');
     return true;
   }
 };
@@ -42,6 +42,7 @@ public:
   class WsClientInterface {
   public:
     string name;
+    uint16_t nameId; ///< Interned name, for producing data
 
     string uri;
     ObsWsClientHost* host;
@@ -55,7 +56,8 @@ public:
     bool identified;
 
     WsClientInterface(string name, string uri, ObsWsClientHost* host, bool autoConnect)
-      : name(name), uri(uri), host(host), autoConnect(autoConnect), websocket_cfg{}
+      : name(name), nameId(ObjMsgData::InternName(name)), uri(uri), host(host),
+        autoConnect(autoConnect), websocket_cfg{}
     {
 
       websocket_cfg.uri = uri.c_str();
@@ -225,8 +227,8 @@ public:
               {
                 ESP_LOGI(ws->host->TAG.c_str(), "Event Data:Event op (%d bytes mem:%d)", data->payload_len,  esp_get_free_heap_size());
                 ObjMsgDataRef data = ObjMsgDataJson::Create(
-                  ws->host->origin_id, ws->name.c_str(), root);
-                ws->host->Produce(data);
+                  ws->host->origin_id, ws->nameId, root);
+                ws->host->Produce(std::move(data));
               }
               // Return so JSON does not get deleted. It is now owned by data
               return;
@@ -237,8 +239,8 @@ public:
               {
                 ESP_LOGI(ws->host->TAG.c_str(), "Event Data:Request-Response op.");
                 ObjMsgDataRef data = ObjMsgDataJson::Create(
-                  ws->host->origin_id, ws->name.c_str(), root);
-                ws->host->Produce(data);
+                  ws->host->origin_id, ws->nameId, root);
+                ws->host->Produce(std::move(data));
               }
               // Return so JSON does not get deleted. It is now owned by data
               return;
@@ -314,10 +316,17 @@ public:
   ObsWsClientHost(ObjMsgTransport* transport, uint16_t origin)
     : ObjMsgHost(transport, "ObsWsClientHost", origin)
   {
+    // Event / response JSON must not delay control data
+    priority = LOW_PRIORITY;
   }
 
   WsClientInterface* Add(string name, const char* url, bool autoConnect = true)
   {
+    if (ObjMsgData::InternName(name) == OBJMSG_NO_NAME)
+    {
+      ESP_LOGE(TAG.c_str(), "Add(%s): name table full", name.c_str());
+      return NULL;
+    }
     interfaces[name] = new WsClientInterface(name, url, this, autoConnect);
     // Select the last interface as active
     //selectedInterface = interfaces[name];
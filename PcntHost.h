@@ -27,6 +27,7 @@ public:
   PcntUnit(string name, ObjMsgSample mode, PcntHost* host)
   {
     this->name = name;
+    this->nameId = ObjMsgData::InternName(name);
     this->mode = mode;
     this->host = host;
 
@@ -40,6 +41,7 @@ public:
     return value;
   }
   string name;
+  uint16_t nameId; ///< Interned name, for producing data
   ObjMsgSample mode;
   PcntHost* host;
 
@@ -79,6 +81,11 @@ public:
   PcntUnit* Add(string name, gpio_num_t inputA, gpio_num_t inputB, encoderType et,
     ObjMsgSample mode, int lowLimit = INT16_MIN, int highLimit = INT16_MAX)
   {
+    if (ObjMsgData::InternName(name) == OBJMSG_NO_NAME)
+    {
+      ESP_LOGE(TAG.c_str(), "Add(%s): name table full", name.c_str());
+      return NULL;
+    }
     units[name] = new PcntUnit(name, mode, this);
     PcntUnit* tmp = units[name];
 
@@ -224,8 +231,8 @@ protected:
         if (unit->mode == CHANGE_EVENT) {
           if (host->Measure(unit)) {
             if (unit->changed) {
-              ObjMsgDataRef point = ObjMsgPcntData::Create(host->origin_id, unit->name.c_str(), unit->value);
-              host->Produce(point);
+              ObjMsgDataRef point = ObjMsgPcntData::Create(host->origin_id, unit->nameId, unit->value);
+              host->Produce(std::move(point));
             }
           }
         }
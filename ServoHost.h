@@ -74,6 +74,11 @@ public:
 
   int Add(const char *name, gpio_num_t pin)
   {
+    if (ObjMsgData::InternName(name) == OBJMSG_NO_NAME)
+    {
+      ESP_LOGE(TAG.c_str(), "Add(%s): name table full", name);
+      return -1;
+    }
     ObjMsgData::RegisterClass(origin_id, name, ObjMsgServoData::Create);
 
     ESP_LOGI(TAG.c_str(), "Create comparator and generator from the operator");
@@ -110,8 +115,8 @@ public:
       MCPWM_GEN_COMPARE_EVENT_ACTION(MCPWM_TIMER_DIRECTION_UP, comparator, 
         MCPWM_GEN_ACTION_LOW),
       MCPWM_GEN_COMPARE_EVENT_ACTION_END()));
-    // Create a servo object and map it by name
-    servos[name] = new Servo(name, pin, comparator);
+    // Create a servo object and map it by name ID
+    servos[ObjMsgData::InternName(name)] = new Servo(name, pin, comparator);
 
     return 0;
   }
@@ -127,20 +132,23 @@ public:
 
   bool Consume(ObjMsgData *data)
   {
-    ObjMsgServoData *point = static_cast<ObjMsgServoData *>(data);
-    if (point)
+    return ConsumeServo(GetServo(data->GetNameId()), data);
+  }
+
+  /// Consume subscribed data; 'context' is the Servo
+  bool ConsumeTopic(ObjMsgData *data, void *context)
+  {
+    return ConsumeServo((Servo *)context, data);
+  }
+
+  /// Subscribe each servo to data of the same name from 'fromOrigin'
+  /// @param fromOrigin: origin of data to consume
+  void SubscribeFrom(uint16_t fromOrigin)
+  {
+    for (unordered_map<uint16_t, Servo *>::iterator it = servos.begin(); it != servos.end(); it++)
     {
-      Servo *servo = GetServo(point->GetName());
-      if (servo) {
-        int angle;
-        point->GetRawValue(angle);
-        angle = std::min(std::max(angle, servo->minAngle), servo->maxAngle);
-        ESP_ERROR_CHECK(mcpwm_comparator_set_compare_value(servo->comparator, 
-          AngleToPulsewidth(angle)));
-        return true;
-      }
+      transport->Subscribe(fromOrigin, it->second->name, this, it->second);
     }
-    return false;
   }
 
 protected:
@@ -159,8 +167,27 @@ protected:
     int minAngle;     /**< Minimum angle in degrees */
   };
 
-  Servo *GetServo(string name) {
-      unordered_map<string, Servo *>::iterator found = servos.find(name);
+  /// Move 'servo' to the angle in 'data'
+  /// @param servo: servo to move (may be NULL)
+  /// @param data: data containing angle
+  /// @return true if moved
+  bool ConsumeServo(Servo *servo, ObjMsgData *data)
+  {
+    ObjMsgServoData *point = data->As<ObjMsgServoData>();
+    if (point && servo)
+    {
+      int angle;
+      point->GetRawValue(angle);
+      angle = std::min(std::max(angle, servo->minAngle), servo->maxAngle);
+      ESP_ERROR_CHECK(mcpwm_comparator_set_compare_value(servo->comparator, 
+        AngleToPulsewidth(angle)));
+      return true;
+    }
+    return false;
+  }
+
+  Servo *GetServo(uint16_t nameId) {
+      unordered_map<uint16_t, Servo *>::iterator found = servos.find(nameId);
       if (found != servos.end()) {
           return found->second;
       }
@@ -169,7 +196,8 @@ protected:
       }
   }
 
-  unordered_map<string, Servo *> servos;
+  /// Servos, by name ID
+  unordered_map<uint16_t, Servo *> servos;
   mcpwm_oper_handle_t oper = NULL;
   mcpwm_timer_handle_t timer = NULL;
 };
@@ -71,7 +71,6 @@ public:
     }
   };
 
-  QueueHandle_t visca_queue;
   ViscaInterface* selectedInterface;
   unordered_map<string, ViscaInterface*> interfaces;
 
@@ -81,11 +80,11 @@ public:
   ViscaHost(ObjMsgTransport* transport, uint16_t origin)
     : ObjMsgHost(transport, "VISCA", origin)
   {
-    visca_queue = xQueueCreate(10, sizeof(Joystick3AxisSample_t));
     selectedInterface = NULL;
 
-    xTaskCreate(Task, "visca_task",
-      CONFIG_ESP_MINIMAL_SHARED_STACK_SIZE + 2048, this, 10, NULL);
+    // VISCA I/O blocks, so consume in an inbox task, keeping only the
+    // latest sample of each joystick
+    SetInbox(10, 10, tskNO_AFFINITY, true);
   }
 
   ViscaInterface* Add(string name, const char* ip, uint16_t port, bool autoConnect = true)
@@ -116,25 +115,34 @@ public:
     return result;
   }
 
-  /** Process a message intended for the VISCA camera control
- */
+  /** Send serial VISCA messages to camera based on joystick samples
+   *
+   * Runs on the inbox task. IT IS ASSUMED that a VISCA message will be sent
+   * for every reception
+   */
   bool Consume(ObjMsgData* data)
   {
-    Joystick3AxisSample_t jd;
-
-    // CHECK TO SEE IF IT IS OBJECT vs string
-    // Is there a safer way to get the object??
-    // joystick data is the object when id is ORIGIN_JOYSTICK_VIEW
-    // AND encoding is JOYSTICK_DATA_STRUCT_ENC
-    Joystick3AxisData* sample = static_cast<Joystick3AxisData*>(data);
-    if (sample != NULL) {
-      sample->GetRawValue(jd);
-      xQueueSend(visca_queue, &jd, 0);
-      return true;
+    Joystick3AxisSample_t js;
+
+    Joystick3AxisData* sample = data->As<Joystick3AxisData>();
+    if (sample == NULL) {
+      ESP_LOGW(TAG.c_str(), "%s is not Joystick3AxisData", data->GetName().data());
+      return false;
+    }
+    sample->GetRawValue(js);
+    //printf("(* %d %d %d)", js.x, js.y, js.z);
+
+    if (selectedInterface) {
+      Acton(selectedInterface, js);
     }
     else {
-      return false;
+      unordered_map<string, ViscaInterface*>::iterator it;
+      for (it = interfaces.begin(); it != interfaces.end(); it++) {
+        ViscaInterface* vf = it->second;
+        Acton(vf, js);
+      }
     }
+    return true;
   }
 
   bool Select(string device) {
@@ -168,37 +176,6 @@ public:
       VISCA_set_zoom_wide_speed(&vf->intf, &vf->camera, ZOOM_SPEED(-js.z));
     }
   }
-  /** Send serial VISCA messages to camera based on joystick samples
-   * received in visca queue, considering measurement state of other
-   * measurements.
-   *
-   * IT IS ASSUMED that a VISCA message will be sent for every reception
-   * serial flow control should be asserted before putting a message
-   * in the visca_queue
-   */
-  static void Task(void* arg)
-  {
-    ViscaHost* ep = (ViscaHost*)arg;
-    for (;;) {
-      Joystick3AxisSample_t js;
-
-      do {
-        xQueueReceive(ep->visca_queue, &js, portMAX_DELAY);
-      } while (uxQueueMessagesWaiting(ep->visca_queue) > 0);
-      //printf("(* %d %d %d)", js.x, js.y, js.z);
-
-      if (ep->selectedInterface) {
-        ep->Acton(ep->selectedInterface, js);
-      }
-      else {
-        unordered_map<string, ViscaInterface*>::iterator it;
-        for (it = ep->interfaces.begin(); it != ep->interfaces.end(); it++) {
-          ViscaInterface* vf = it->second;
-          ep->Acton(vf, js);
-        }
-      }
-    }
-  }
 private:
   static void print_camera_info(ViscaInterface* vf)
   {
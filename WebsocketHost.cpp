@@ -6,6 +6,7 @@
 #include <esp_system.h>
 #include <nvs_flash.h>
 #include <sys/param.h>
+#include "lwip/sockets.h"
 #include "nvs_flash.h"
 #include "esp_smartconfig.h"
 
@@ -18,6 +19,18 @@ static const int ESPTOUCH_DONE_BIT = BIT1;
 
 httpd_handle_t server;
 
+//
+// State of a newly connected client; it receives all data until it subscribes
+//
+static ws_client_t WebSockNewClient(int fd)
+{
+  ws_client_t client;
+  memset(&client, 0, sizeof(client));
+  client.fd = fd;
+  client.all = true;
+  return client;
+}
+
 /*       ___  _     _ __  __         _  _        _
  *      / _ \| |__ (_)  \/  |_____ _| || |___ __| |_
  *     | (_) | '_ \| | |\/| (_-< _` | __ / _ (_-<  _|
@@ -34,6 +47,21 @@ WebsocketHost::WebsocketHost(ObjMsgTransport *transport, uint16_t origin,
   this->led = led;
   this->resetWifi = false;
   wifi_event_group = xEventGroupCreate();
+  clientsLock = xSemaphoreCreateMutex();
+  batchWindowMs = 0;
+  batchBudget = WS_BATCH_BUDGET;
+  batchFormat = JSON_FORMAT;
+  pendingBytes = 0;
+  pendingLock = xSemaphoreCreateMutex();
+  windowStart = xSemaphoreCreateBinary();
+  windowOpen = false;
+  queueDepth = WS_QUEUE_DEPTH;
+  queuePolicy = DROP_OLDEST_POLICY;
+  disconnectDrops = WS_DISCONNECT_DROPS;
+  retryTimer = NULL;
+  receivedHead = 0;
+  receivedCount = 0;
+  receivedPending = xSemaphoreCreateCounting(WS_RECV_QUEUE_DEPTH, 0);
 }
 
 bool WebsocketHost::Add(const char *path, esp_err_t (*fn)(httpd_req_t *req), bool ws)
@@ -50,6 +78,20 @@ bool WebsocketHost::Add(const char *path, esp_err_t (*fn)(httpd_req_t *req), boo
   return true;
 }
 
+void WebsocketHost::SetBatching(uint16_t windowMs, size_t budget, ObjMsgFormat format)
+{
+  batchWindowMs = windowMs;
+  batchBudget = budget;
+  batchFormat = format;
+}
+
+void WebsocketHost::SetSendQueue(uint16_t depth, WsQueuePolicy policy, uint16_t disconnectDrops)
+{
+  queueDepth = depth ? depth : 1;
+  queuePolicy = policy;
+  this->disconnectDrops = disconnectDrops;
+}
+
 bool WebsocketHost::Start()
 {
   isConnected = false;
@@ -68,6 +110,23 @@ bool WebsocketHost::Start()
   // Init websocket handler
   Add("/ws", WebSockMsgHandler, true);
 
+  esp_timer_create_args_t retry;
+  memset(&retry, 0, sizeof(retry));
+  retry.callback = RetryTimer;
+  retry.arg = this;
+  retry.name = "ws_retry";
+  ESP_ERROR_CHECK(esp_timer_create(&retry, &retryTimer));
+
+  // Messages received by the httpd task are parsed by ReceiveTask
+  xTaskCreate(ReceiveTask, "ws_recv_task", CONFIG_ESP_MINIMAL_SHARED_STACK_SIZE + 2048,
+              this, tskIDLE_PRIORITY + 5, NULL);
+
+  if (batchWindowMs)
+  {
+    xTaskCreate(BatchTask, "ws_batch_task", CONFIG_ESP_MINIMAL_SHARED_STACK_SIZE + 1024,
+                this, tskIDLE_PRIORITY + 5, NULL);
+  }
+
   if (led != GPIO_NUM_NC)
   {
     ledPattern = LED_PATTERN_CONNECTING;
@@ -123,26 +182,159 @@ void WebsocketHost::SetConnected(bool connected)
   isConnected = connected;
 }
 
+vector<ws_client_t> WebsocketHost::GetClients()
+{
+  vector<ws_client_t> copy;
+  xSemaphoreTake(clientsLock, portMAX_DELAY);
+  copy.reserve(clients.size());
+  for (unordered_map<int, ws_connection_t>::iterator it = clients.begin(); it != clients.end(); it++)
+  {
+    copy.push_back(it->second.info);
+  }
+  xSemaphoreGive(clientsLock);
+  return copy;
+}
+
+ws_connection_t &WebsocketHost::Client(int fd)
+{
+  unordered_map<int, ws_connection_t>::iterator found = clients.find(fd);
+  if (found == clients.end())
+  {
+    found = clients.emplace(fd, ws_connection_t()).first;
+    found->second.info = WebSockNewClient(fd);
+    found->second.queue.resize(queueDepth);
+  }
+  return found->second;
+}
+
 bool WebsocketHost::Consume(ObjMsgData *data)
 {
-  if (server)
+  ObjMsgData *batch[] = {data};
+  return ConsumeBatch(batch) > 0;
+}
+
+int WebsocketHost::ConsumeBatch(span<ObjMsgData *> batch)
+{
+  if (!server)
   {
-    
-    string str;
-    data->Serialize(str);
-    const char *json = str.c_str();
-    // ESP_LOGW("Websocket", "INVOKE async_broadcast");
-    int err = httpd_queue_work(server, WebSockAsyncBroadcast, strdup(json));
-    if (err != ESP_OK)
+    return 0;
+  }
+  bool batched = batchWindowMs > 0;
+  ObjMsgFormat format = batched ? batchFormat : JSON_FORMAT;
+  int consumed = 0;
+
+  xSemaphoreTake(pendingLock, portMAX_DELAY);
+  for (ObjMsgData *data : batch)
+  {
+    ObjMsgBufferRef encoded = data->Encode(format);
+    if (!encoded)
+    {
+      continue;
+    }
+    consumed++;
+    pendingBytes += encoded->Size();
+    if (batched && data->GetNameId() != OBJMSG_NO_NAME)
     {
-      ESP_LOGE(TAG.c_str(), "Consume(%s)=>%d", json, err);
+      // Conflate; the latest data of an origin and name keeps its place.
+      // Data that could not be named is never taken for another of its kind
+      vector<ws_pending_t>::iterator it = pending.begin();
+      while (it != pending.end() && !(it->origin == data->GetOrigin() && it->nameId == data->GetNameId()))
+      {
+        it++;
+      }
+      if (it != pending.end())
+      {
+        pendingBytes -= it->encoded->Size();
+        it->encoded = std::move(encoded);
+        continue;
+      }
     }
+    pending.push_back({data->GetOrigin(), data->GetNameId(), std::move(encoded)});
+  }
+  if (!batched || pendingBytes >= batchBudget)
+  {
+    if (!Broadcast(batched) && !batched)
+    {
+      consumed = 0;
+    }
+  }
+  else if (!windowOpen && !pending.empty())
+  {
+    // Data sent early, when over budget, leaves the window open, so there is
+    // at most one give per window
+    windowOpen = true;
+    xSemaphoreGive(windowStart);
+  }
+  xSemaphoreGive(pendingLock);
+  return consumed;
+}
+
+bool WebsocketHost::Broadcast(bool batched)
+{
+  if (pending.empty())
+  {
     return true;
   }
+  // Hand the frames to a recycled work item; the encodings are shared, not
+  // copied, and 'pending' takes the work item's empty frame capacity
+  ws_work_t *work;
+  if (spareWork.empty())
+  {
+    work = new ws_work_t;
+  }
   else
   {
+    work = spareWork.back();
+    spareWork.pop_back();
+  }
+  work->host = this;
+  work->batched = batched;
+  work->format = batched ? batchFormat : JSON_FORMAT;
+  work->queued = esp_timer_get_time();
+  work->frames.swap(pending);
+  pendingBytes = 0;
+
+  // ESP_LOGW("Websocket", "INVOKE async_broadcast");
+  int err = httpd_queue_work(server, WebSockAsyncBroadcast, work);
+  if (err != ESP_OK)
+  {
+    ESP_LOGE(TAG.c_str(), "Broadcast(%u)=>%d", (unsigned)work->frames.size(), err);
+    work->frames.clear();
+    spareWork.push_back(work);
     return false;
   }
+  return true;
+}
+
+void WebsocketHost::RecycleWork(ws_work_t *work)
+{
+  // Release the frames, keeping their capacity
+  work->frames.clear();
+  xSemaphoreTake(pendingLock, portMAX_DELAY);
+  spareWork.push_back(work);
+  xSemaphoreGive(pendingLock);
+}
+
+//
+// Batching window task; a window starts with its first data
+//
+void WebsocketHost::BatchTask(void *arg)
+{
+  WebsocketHost *host = (WebsocketHost *)arg;
+  for (;;)
+  {
+    if (xSemaphoreTake(host->windowStart, portMAX_DELAY))
+    {
+      vTaskDelay(pdMS_TO_TICKS(host->batchWindowMs));
+      xSemaphoreTake(host->pendingLock, portMAX_DELAY);
+      host->windowOpen = false;
+      if (server)
+      {
+        host->Broadcast(true);
+      }
+      xSemaphoreGive(host->pendingLock);
+    }
+  }
 }
 
 /*     __      __   _               _       _
@@ -153,45 +345,515 @@ bool WebsocketHost::Consume(ObjMsgData *data)
  */
 
 //
-// async send function broadcast worker)
+// Check if 'client' subscribes to data of 'origin' and 'nameId'
 //
-void WebsocketHost::WebSockAsyncBroadcast(void *arg)
+static bool WebSockWants(const ws_client_t *client, uint16_t origin, uint16_t nameId)
+{
+  if (client->all)
+  {
+    return true;
+  }
+  for (int i = 0; i < client->originCount; i++)
+  {
+    if (client->origins[i] == origin)
+    {
+      return true;
+    }
+  }
+  for (int i = 0; i < client->nameCount; i++)
+  {
+    if (client->names[i] == nameId)
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+//
+// Build the frame of the 'count' frames of 'work' that 'client' subscribes to,
+// totalling 'bytes', in one (pooled) buffer
+//
+static ObjMsgBufferRef WebSockBatch(ws_work_t *work, const ws_client_t *client, uint32_t count, size_t bytes)
+{
+  bool binary = work->format == BINARY_FORMAT;
+  // MessagePack array header, or brackets and commas
+  size_t header = !binary ? 1 : count < 16 ? 1 : count < 0x10000 ? 3 : 5;
+  ObjMsgBufferRef batch = ObjMsgBuffer::Create(binary ? header + bytes : bytes + count + 1);
+  if (!batch)
+  {
+    return batch;
+  }
+  uint8_t *out = batch->Writable();
+  if (!binary)
+  {
+    *out++ = '[';
+  }
+  else if (count < 16)
+  {
+    *out++ = 0x90 | count;
+  }
+  else
+  {
+    *out++ = count < 0x10000 ? 0xdc : 0xdd;
+    for (int shift = (header - 2) * 8; shift >= 0; shift -= 8)
+    {
+      *out++ = count >> shift;
+    }
+  }
+  for (ws_pending_t &frame : work->frames)
+  {
+    if (WebSockWants(client, frame.origin, frame.nameId))
+    {
+      memcpy(out, frame.encoded->Data(), frame.encoded->Size());
+      out += frame.encoded->Size();
+      if (!binary)
+      {
+        *out++ = ',';
+      }
+    }
+  }
+  if (!binary)
+  {
+    out[-1] = ']';
+  }
+  return batch;
+}
+
+//
+// Check if socket 'fd' has room to send, without waiting
+//
+static bool WebSockWritable(int fd)
+{
+  fd_set writable;
+  FD_ZERO(&writable);
+  FD_SET(fd, &writable);
+  struct timeval now = {0, 0};
+  return select(fd + 1, NULL, &writable, NULL, &now) > 0;
+}
+
+//
+// Send queued 'frame' to 'fd'
+//
+static esp_err_t WebSockSend(int fd, ws_queued_t &frame)
 {
   httpd_ws_frame_t ws_pkt;
   memset(&ws_pkt, 0, sizeof(ws_pkt));
-  ws_pkt.payload = (uint8_t *)arg;
-  ws_pkt.type = HTTPD_WS_TYPE_TEXT;
-  ws_pkt.len = strlen((char *)arg);
+  ws_pkt.payload = (uint8_t *)frame.frame->Data();
+  ws_pkt.len = frame.frame->Size();
+  ws_pkt.type = frame.type;
   ws_pkt.final = true;
+  esp_err_t err = httpd_ws_send_frame_async(server, fd, &ws_pkt);
+  if (err)
+  {
+    ESP_LOGE("ASYNC-Broadcast", "error: %d)", err);
+  }
+  return err;
+}
+
+void WebsocketHost::Enqueue(ws_connection_t &client, ws_queued_t &frame)
+{
+  ws_client_t &info = client.info;
+  if (client.closing)
+  {
+    return;
+  }
+  if (queuePolicy == CONFLATE_POLICY && frame.nameId != OBJMSG_NO_NAME)
+  {
+    for (uint16_t i = 0; i < info.depth; i++)
+    {
+      ws_queued_t &queued = client.queue[(client.head + i) % queueDepth];
+      if (queued.origin == frame.origin && queued.nameId == frame.nameId)
+      {
+        // The newer data takes the waiting frame's place, and its latency
+        queued.frame = std::move(frame.frame);
+        info.conflated++;
+        return;
+      }
+    }
+  }
+  if (info.depth == queueDepth)
+  {
+    client.queue[client.head].frame.reset();
+    client.head = (client.head + 1) % queueDepth;
+    info.depth--;
+    info.dropped++;
+    client.unsent++;
+  }
+  client.queue[(client.head + info.depth) % queueDepth] = std::move(frame);
+  if (++info.depth > info.highWater)
+  {
+    info.highWater = info.depth;
+  }
+}
 
-  // ESP_LOGW("Websocket", "async_broadcast(%p:%d bytes) mem:%d", arg, strlen((char *)arg), esp_get_free_heap_size());
+void WebsocketHost::Drain()
+{
+  bool backlog = false;
+  for (unordered_map<int, ws_connection_t>::iterator it = clients.begin(); it != clients.end(); it++)
+  {
+    int fd = it->first;
+    ws_connection_t &client = it->second;
+    if (client.closing)
+    {
+      continue;
+    }
+    if (disconnectDrops && client.unsent >= disconnectDrops)
+    {
+      ESP_LOGW(TAG.c_str(), "Disconnecting client %d; %u frames dropped, none sent", fd, client.unsent);
+      xSemaphoreTake(clientsLock, portMAX_DELAY);
+      client.closing = true;
+      for (; client.info.depth; client.info.depth--)
+      {
+        client.queue[client.head].frame.reset();
+        client.head = (client.head + 1) % queueDepth;
+      }
+      xSemaphoreGive(clientsLock);
+      httpd_sess_trigger_close(server, fd);
+      continue;
+    }
+    while (client.info.depth)
+    {
+      // A congested client keeps its frames, rather than blocking the others
+      if (!WebSockWritable(fd))
+      {
+        backlog = true;
+        break;
+      }
+      xSemaphoreTake(clientsLock, portMAX_DELAY);
+      ws_queued_t frame = std::move(client.queue[client.head]);
+      client.head = (client.head + 1) % queueDepth;
+      client.info.depth--;
+      xSemaphoreGive(clientsLock);
+
+      esp_err_t err = WebSockSend(fd, frame);
+      uint32_t latency = esp_timer_get_time() - frame.queued;
+
+      xSemaphoreTake(clientsLock, portMAX_DELAY);
+      if (err)
+      {
+        client.info.failed++;
+      }
+      else
+      {
+        client.info.sent++;
+        client.info.latencyTotalUs += latency;
+        if (latency > client.info.latencyMaxUs)
+        {
+          client.info.latencyMaxUs = latency;
+        }
+        client.unsent = 0;
+      }
+      xSemaphoreGive(clientsLock);
+      if (err)
+      {
+        // The socket is failing; httpd will close it
+        break;
+      }
+    }
+  }
+  if (backlog && retryTimer && !esp_timer_is_active(retryTimer))
+  {
+    esp_timer_start_once(retryTimer, WS_RETRY_MS * 1000);
+  }
+}
+
+//
+// Drain worker, queued by RetryTimer
+//
+void WebsocketHost::WebSockDrain(void *arg)
+{
+  ((WebsocketHost *)arg)->Drain();
+}
+
+//
+// Retry clients whose socket was full, on the httpd task
+//
+void WebsocketHost::RetryTimer(void *arg)
+{
+  if (server)
+  {
+    httpd_queue_work(server, WebSockDrain, arg);
+  }
+}
+
+//
+// async send function broadcast worker)
+//
+// 'arg' is a ws_work_t; each of its frames is queued for the clients
+// subscribed to its origin or name, or when batched, combined into one frame
+// per client. The frames are shared by every client queue, and by other
+// consumers of the data; each is released once its last send completes
+//
+void WebsocketHost::WebSockAsyncBroadcast(void *arg)
+{
+  // ESP_LOGW("Websocket", "async_broadcast(%p) mem:%d", arg, esp_get_free_heap_size());
 
   static size_t max_clients = CONFIG_LWIP_MAX_LISTENING_TCP;
   size_t fds = max_clients;
   int client_fds[max_clients];
+  ws_work_t *work = (ws_work_t *)arg;
+  WebsocketHost *host = work->host;
 
   esp_err_t ret = httpd_get_client_list(server, &fds, client_fds);
   if (ret != ESP_OK)
   {
-   free(arg);
-   return;
+    host->RecycleWork(work);
+    return;
   }
 
-  for (int i = 0; i < fds; i++)
+  // Find (or add) each websocket client, and forget those that have closed.
+  // Only this task changes 'clients', so its entries are stable
+  ws_connection_t *targets[max_clients];
+  size_t count = 0;
+  xSemaphoreTake(host->clientsLock, portMAX_DELAY);
+  for (unordered_map<int, ws_connection_t>::iterator it = host->clients.begin(); it != host->clients.end();)
   {
-    int client_info = httpd_ws_get_fd_info(server, client_fds[i]);
-    if (client_info == HTTPD_WS_CLIENT_WEBSOCKET)
+    if (std::find(client_fds, client_fds + fds, it->first) == client_fds + fds)
     {
-      int err = httpd_ws_send_frame_async(server, client_fds[i], &ws_pkt);
-      if (err)
+      it = host->clients.erase(it);
+    }
+    else
+    {
+      it++;
+    }
+  }
+  for (size_t i = 0; i < fds; i++)
+  {
+    if (httpd_ws_get_fd_info(server, client_fds[i]) == HTTPD_WS_CLIENT_WEBSOCKET)
+    {
+      targets[count++] = &host->Client(client_fds[i]);
+    }
+  }
+
+  ws_queued_t queued;
+  queued.type = work->format == BINARY_FORMAT ? HTTPD_WS_TYPE_BINARY : HTTPD_WS_TYPE_TEXT;
+  queued.queued = work->queued;
+  if (work->batched)
+  {
+    // One frame per client, of the data it subscribes to. Clients of every
+    // frame share one
+    ObjMsgBufferRef all;
+    queued.origin = 0;
+    queued.nameId = OBJMSG_NO_NAME;
+    for (size_t i = 0; i < count; i++)
+    {
+      uint32_t matches = 0;
+      size_t bytes = 0;
+      for (ws_pending_t &frame : work->frames)
+      {
+        if (WebSockWants(&targets[i]->info, frame.origin, frame.nameId))
+        {
+          matches++;
+          bytes += frame.encoded->Size();
+        }
+      }
+      if (!matches)
+      {
+        continue;
+      }
+      ObjMsgBufferRef own;
+      ObjMsgBufferRef &batch = matches == work->frames.size() ? all : own;
+      if (!batch)
+      {
+        batch = WebSockBatch(work, &targets[i]->info, matches, bytes);
+      }
+      if (batch)
+      {
+        queued.frame = batch;
+        host->Enqueue(*targets[i], queued);
+      }
+      else
+      {
+        targets[i]->info.dropped++;
+      }
+    }
+  }
+  else
+  {
+    for (ws_pending_t &frame : work->frames)
+    {
+      queued.origin = frame.origin;
+      queued.nameId = frame.nameId;
+      for (size_t i = 0; i < count; i++)
       {
-        ESP_LOGE("ASYNC-Broadcast", "error: %d)", err);
+        if (WebSockWants(&targets[i]->info, frame.origin, frame.nameId))
+        {
+          queued.frame = frame.encoded;
+          host->Enqueue(*targets[i], queued);
+        }
       }
     }
   }
+  queued.frame.reset();
+  xSemaphoreGive(host->clientsLock);
 
-  free(arg);
-  // ESP_LOGW("Websocket", "async_broadcast free(%p) mem:%d", arg, esp_get_free_heap_size());
+  host->RecycleWork(work);
+  host->Drain();
+  // ESP_LOGW("Websocket", "async_broadcast done(%p) mem:%d", arg, esp_get_free_heap_size());
+}
+
+bool WebsocketHost::Subscribe(int fd, string_view value)
+{
+  ws_client_t interest;
+  memset(&interest, 0, sizeof(interest));
+  string all;
+  if (ObjMsgJsonReader::String(value, all))
+  {
+    if (all != "*")
+    {
+      return false;
+    }
+    interest.all = true;
+  }
+  else
+  {
+    ObjMsgJsonReader reader(value);
+    string_view key, list, item;
+    while (reader.Next(key, list))
+    {
+      ObjMsgJsonReader items(list);
+      if (key == "names")
+      {
+        string name;
+        while (items.Next(item) && ObjMsgJsonReader::String(item, name))
+        {
+          uint16_t nameId = ObjMsgData::FindName(name);
+          if (nameId != OBJMSG_NO_NAME && interest.nameCount < WS_MAX_INTERESTS)
+          {
+            interest.names[interest.nameCount++] = nameId;
+          }
+        }
+      }
+      else if (key == "origins")
+      {
+        int64_t origin;
+        while (items.Next(item) && ObjMsgJsonReader::Int(item, origin))
+        {
+          if (origin < 0 || origin > UINT16_MAX)
+          {
+            return false;
+          }
+          if (interest.originCount < WS_MAX_INTERESTS)
+          {
+            interest.origins[interest.originCount++] = origin;
+          }
+        }
+      }
+      else
+      {
+        continue;
+      }
+      if (!items.Done())
+      {
+        return false;
+      }
+    }
+    if (!reader.Done())
+    {
+      return false;
+    }
+  }
+
+  // Called from ReceiveTask, so only update a client the httpd task added
+  xSemaphoreTake(clientsLock, portMAX_DELAY);
+  unordered_map<int, ws_connection_t>::iterator found = clients.find(fd);
+  if (found != clients.end())
+  {
+    ws_client_t &client = found->second.info;
+    client.all = interest.all;
+    client.nameCount = interest.nameCount;
+    client.originCount = interest.originCount;
+    memcpy(client.names, interest.names, sizeof(client.names));
+    memcpy(client.origins, interest.origins, sizeof(client.origins));
+  }
+  xSemaphoreGive(clientsLock);
+  return true;
+}
+
+//
+// Receiving
+//
+bool WebsocketHost::PostReceived(int fd, ObjMsgBufferRef &message)
+{
+  bool posted = false;
+  portENTER_CRITICAL(&receivedLock);
+  if (receivedCount < WS_RECV_QUEUE_DEPTH)
+  {
+    ws_received_t &slot = received[(receivedHead + receivedCount) % WS_RECV_QUEUE_DEPTH];
+    slot.fd = fd;
+    slot.message.swap(message); // Slot is empty, nothing released here
+    receivedCount++;
+    posted = true;
+  }
+  portEXIT_CRITICAL(&receivedLock);
+  if (posted)
+  {
+    xSemaphoreGive(receivedPending);
+  }
+  return posted;
+}
+
+void WebsocketHost::ReceiveTask(void *arg)
+{
+  WebsocketHost *host = (WebsocketHost *)arg;
+  for (;;)
+  {
+    if (xSemaphoreTake(host->receivedPending, portMAX_DELAY))
+    {
+      ws_received_t job;
+      portENTER_CRITICAL(&host->receivedLock);
+      ws_received_t &slot = host->received[host->receivedHead];
+      job.fd = slot.fd;
+      job.message.swap(slot.message);
+      host->receivedHead = (host->receivedHead + 1) % WS_RECV_QUEUE_DEPTH;
+      host->receivedCount--;
+      portEXIT_CRITICAL(&host->receivedLock);
+
+      host->Receive(job.fd, string_view(job.message->c_str(), job.message->Size()));
+    }
+  }
+}
+
+void WebsocketHost::Receive(int fd, string_view message)
+{
+  size_t start = message.find_first_not_of(" \t\r\n");
+  if (start != string_view::npos && message[start] == '[')
+  {
+    // A batch of messages
+    ObjMsgJsonReader batch(message);
+    string_view element;
+    while (batch.Next(element))
+    {
+      ReceiveMessage(fd, element);
+    }
+    if (!batch.Done())
+    {
+      ESP_LOGW(TAG.c_str(), "Malformed batch: %.*s", (int)message.size(), message.data());
+    }
+  }
+  else
+  {
+    ReceiveMessage(fd, message);
+  }
+}
+
+void WebsocketHost::ReceiveMessage(int fd, string_view message)
+{
+  string_view name, value;
+  if (ObjMsgJsonReader::Member(message, "name", name) && name == "\"__WS_SUBSCRIBE__\"")
+  {
+    if (!ObjMsgJsonReader::Member(message, "value", value) || !Subscribe(fd, value))
+    {
+      ESP_LOGW(TAG.c_str(), "Malformed subscription: %.*s", (int)message.size(), message.data());
+    }
+    return;
+  }
+  ObjMsgDataRef data = ObjMsgData::Deserialize(origin_id, message);
+  if (data)
+  {
+    Produce(std::move(data));
+  }
 }
 
 //
@@ -200,29 +862,100 @@ void WebsocketHost::WebSockAsyncBroadcast(void *arg)
 esp_err_t WebsocketHost::WebSockMsgHandler(httpd_req_t *req)
 {
   WebsocketHost *host = (WebsocketHost *)req->user_ctx;
+  int fd = httpd_req_to_sockfd(req);
 
   if (req->method == HTTP_GET)
   {
     ESP_LOGI(host->TAG.c_str(), "Handshake done, the Websocket connection was opened");
+    // A new client on a reused socket starts with all data, and no counts
+    xSemaphoreTake(host->clientsLock, portMAX_DELAY);
+    host->clients.erase(fd);
+    host->Client(fd);
+    xSemaphoreGive(host->clientsLock);
     return ESP_OK;
   }
 
-  char message[128] = {0};
   httpd_ws_frame_t ws_pkt;
-
   memset(&ws_pkt, 0, sizeof(httpd_ws_frame_t));
-  ws_pkt.payload = (uint8_t *)message;
-  ws_pkt.type = HTTPD_WS_TYPE_TEXT;
 
-  esp_err_t ret = httpd_ws_recv_frame(req, &ws_pkt, sizeof(message));
+  // Read the frame's type and length, then its payload
+  esp_err_t ret = httpd_ws_recv_frame(req, &ws_pkt, 0);
   if (ret != ESP_OK)
   {
     ESP_LOGE(host->TAG.c_str(), "httpd_ws_recv_frame failed with error %d", ret);
     return ret;
   }
-  host->Produce(message);
 
-  return ret;
+  // Fragments are accumulated per client; only the httpd task touches them
+  xSemaphoreTake(host->clientsLock, portMAX_DELAY);
+  ws_connection_t &client = host->Client(fd);
+  xSemaphoreGive(host->clientsLock);
+  vector<char> &partial = client.partial;
+
+  bool continued = ws_pkt.type == HTTPD_WS_TYPE_CONTINUE;
+  if (!continued)
+  {
+    partial.clear(); // A new message abandons an unfinished one
+    client.partialType = ws_pkt.type;
+  }
+  size_t offset = partial.size();
+  if (offset + ws_pkt.len > WS_RECV_MAX)
+  {
+    ESP_LOGE(host->TAG.c_str(), "Message exceeds %d bytes, closing", WS_RECV_MAX);
+    vector<char>().swap(partial);
+    return ESP_FAIL; // httpd closes the socket
+  }
+
+  ObjMsgBufferRef message;
+  if (ws_pkt.final && !continued)
+  {
+    // Whole message in one frame, received straight into a pooled buffer
+    message = ObjMsgBuffer::Create(ws_pkt.len);
+    if (!message)
+    {
+      return ESP_ERR_NO_MEM;
+    }
+    ws_pkt.payload = message->Writable();
+  }
+  else
+  {
+    partial.resize(offset + ws_pkt.len);
+    ws_pkt.payload = (uint8_t *)partial.data() + offset;
+  }
+  if (ws_pkt.len)
+  {
+    ret = httpd_ws_recv_frame(req, &ws_pkt, ws_pkt.len);
+    if (ret != ESP_OK)
+    {
+      ESP_LOGE(host->TAG.c_str(), "httpd_ws_recv_frame failed with error %d", ret);
+      return ret;
+    }
+  }
+  if (!ws_pkt.final)
+  {
+    return ESP_OK; // Wait for the rest
+  }
+  httpd_ws_type_t type = client.partialType;
+  client.partialType = HTTPD_WS_TYPE_CONTINUE; // A stray continuation is ignored
+  if (!message)
+  {
+    message = ObjMsgBuffer::Create(partial.data(), partial.size());
+    partial.clear();
+    if (!message)
+    {
+      return ESP_ERR_NO_MEM;
+    }
+  }
+
+  if (type != HTTPD_WS_TYPE_TEXT)
+  {
+    ESP_LOGW(host->TAG.c_str(), "Ignoring non-text message (type %d)", type);
+  }
+  else if (!host->PostReceived(fd, message))
+  {
+    ESP_LOGW(host->TAG.c_str(), "Receive queue full, message dropped");
+  }
+  return ESP_OK;
 }
 
 /*
@@ -478,7 +1211,9 @@ void WebsocketHost::WifiScan(void)
 
   for (int i = 0; (i < DEFAULT_SCAN_LIST_SIZE) && (i < ap_count); i++)
   {
-    Produce(ObjMsgDataString::Create(origin_id, "__WS_AP__", (const char *)ap_info[i].ssid));
+    // Scan results are informational; keep them behind control data
+    transport->Send(ObjMsgDataString::Create(origin_id, "__WS_AP__", (const char *)ap_info[i].ssid),
+                    LOW_PRIORITY);
     ESP_LOGI(TAG.c_str(), "SSID \t\t%s", ap_info[i].ssid);
     ESP_LOGI(TAG.c_str(), "RSSI \t\t%d", ap_info[i].rssi);
     ESP_LOGI(TAG.c_str(), "Channel \t%d", ap_info[i].primary);
@@ -6,6 +6,7 @@
 
 #include "ObjMsg.h"
 #include <list>
+#include <esp_timer.h>
 
 /*
  * Built in messages:
@@ -20,6 +21,14 @@
  *  __WS_APSCAN__ begin
  *  __WS_AP__ <access point> (for each detected)
  *  __WS_APSCAN__ end
+ *
+ * Messages from /ws clients may be sent alone, fragmented, or batched as a JSON
+ * array of messages in one frame. They are parsed and produced by a task, not
+ * by the httpd task.
+ *
+ * Subscription (sent by a /ws client; consumed by WebsocketHost, not produced)
+ *  __WS_SUBSCRIBE__ {"names":[<name>, ...], "origins":[<origin>, ...]}
+ *  __WS_SUBSCRIBE__ "*"
  */
 
 // LED Patterns; 16 member sequence of LED On/Off bits, applied at 250ms interval
@@ -27,6 +36,95 @@
 #define LED_PATTERN_PROVISIONING 0x55ee // 2 long, 4 short      0x5555  // 1/2 sec beat
 #define LED_PATTERN_GOT_PW  0x5555  // 1/2 sec beat
 
+#define WS_MAX_INTERESTS 8 ///< Names, and origins, a client may subscribe to
+#define WS_BATCH_BUDGET 1024 ///< Default encoded bytes that end a batching window early
+#define WS_QUEUE_DEPTH 8 ///< Default frames queued per client
+#define WS_DISCONNECT_DROPS 64 ///< Default frames dropped, with none sent, that disconnect a client
+#define WS_RETRY_MS 20 ///< Interval to retry clients whose socket was full
+#define WS_RECV_MAX 8192 ///< Largest message received, after reassembly; larger closes the connection
+#define WS_RECV_QUEUE_DEPTH 8 ///< Received messages waiting to be parsed
+
+/// What a full client send queue discards (see WebsocketHost::SetSendQueue())
+enum WsQueuePolicy
+{
+  DROP_OLDEST_POLICY, /**< Discard the oldest waiting frame to make room */
+  CONFLATE_POLICY     /**< Replace a waiting frame of the same origin and name
+                           (full or not), unless unnamed; otherwise discard
+                           the oldest */
+};
+
+/// A /ws client's subscription and send queue statistics
+///
+/// A client receives all data until it sends __WS_SUBSCRIBE__; then only data
+/// matching one of its names or origins. Each subscription replaces the last,
+/// and "*" restores all data. Names not yet interned are ignored.
+typedef struct
+{
+  int fd;              ///< Socket
+  bool all;            ///< Receives all data
+  uint8_t nameCount;   ///< Entries in 'names'
+  uint8_t originCount; ///< Entries in 'origins'
+  uint16_t names[WS_MAX_INTERESTS];   ///< Name IDs of interest
+  uint16_t origins[WS_MAX_INTERESTS]; ///< Origins of interest
+  uint16_t depth;      ///< Frames queued
+  uint16_t highWater;  ///< Maximum frames queued
+  uint32_t sent;       ///< Frames sent
+  uint32_t dropped;    ///< Frames discarded because the queue was full
+  uint32_t conflated;  ///< Queued frames replaced by newer data (CONFLATE_POLICY)
+  uint32_t failed;     ///< Frames that failed to send
+  uint32_t latencyMaxUs;   ///< Maximum time from broadcast to sent
+  uint64_t latencyTotalUs; ///< Sum of times from broadcast to sent (divide by 'sent' for mean)
+} ws_client_t;
+
+/// A frame waiting in a client's send queue
+typedef struct
+{
+  ObjMsgBufferRef frame;
+  httpd_ws_type_t type;
+  uint16_t origin;
+  uint16_t nameId;  ///< OBJMSG_NO_NAME for batches, which are not conflated
+  int64_t queued;   ///< When broadcast, from esp_timer_get_time()
+} ws_queued_t;
+
+/// A /ws client: its statistics, and its send queue
+typedef struct
+{
+  ws_client_t info;
+  vector<ws_queued_t> queue; ///< Ring of queued frames
+  uint16_t head;             ///< Oldest queued frame
+  uint16_t unsent;           ///< Frames dropped since one was sent
+  bool closing;              ///< Disconnected for dropping too many frames
+  vector<char> partial;      ///< Fragments of the message being received
+  httpd_ws_type_t partialType; ///< Type of the message being received
+} ws_connection_t;
+
+/// A received message, waiting to be parsed
+typedef struct
+{
+  int fd;
+  ObjMsgBufferRef message;
+} ws_received_t;
+
+/// Consumed data waiting to be sent; the encoding is shared with other consumers
+typedef struct
+{
+  uint16_t origin;
+  uint16_t nameId;
+  ObjMsgBufferRef encoded;
+} ws_pending_t;
+
+class WebsocketHost;
+
+/// A broadcast of frames, queued to the httpd task; work items are recycled
+typedef struct
+{
+  WebsocketHost *host;
+  bool batched;        ///< Frames are combined into one per client
+  ObjMsgFormat format; ///< Encoding of the frames
+  int64_t queued;      ///< When queued to the httpd task
+  vector<ws_pending_t> frames;
+} ws_work_t;
+
 /** WiFi / httpd / Websocket ObjMsgHost with Smartconfig commissioning
  * 
  * 
@@ -52,11 +150,46 @@ public:
   /// @param ws: host type - true == ws, false = httpd
   /// @return bool - Successfully added
   bool Add(const char *path, esp_err_t (*fn)(httpd_req_t *req), bool ws);
+
+  /// Batch consumed data, sending each client one frame per window
+  ///
+  /// The window starts with the first data consumed, and ends after
+  /// 'windowMs', or once 'budget' encoded bytes are waiting. Data of the same
+  /// origin and name within a window is conflated, keeping the latest; data
+  /// without a name ID (OBJMSG_NO_NAME) never is. Each client's frame holds
+  /// the data it subscribes to: a JSON array of messages, or for BINARY_FORMAT
+  /// a MessagePack array of [name, value] arrays.
+  /// Call before Start()
+  /// @param windowMs: batching window; 0 sends a frame per data, as consumed
+  /// @param budget: encoded bytes that end the window early
+  /// @param format: frame encoding
+  void SetBatching(uint16_t windowMs, size_t budget = WS_BATCH_BUDGET,
+                   ObjMsgFormat format = JSON_FORMAT);
+
+  /// Configure each client's send queue
+  ///
+  /// Frames are queued per client, and sent only while the client's socket
+  /// has room. A client on a congested link backs up, drops and eventually
+  /// disconnects on its own, without delaying others. Call before Start()
+  /// @param depth: frames queued per client
+  /// @param policy: what a full queue discards
+  /// @param disconnectDrops: frames dropped, with none sent, that disconnect
+  /// the client; 0 never disconnects
+  void SetSendQueue(uint16_t depth, WsQueuePolicy policy = DROP_OLDEST_POLICY,
+                    uint16_t disconnectDrops = WS_DISCONNECT_DROPS);
+
   bool Start();
   bool Consume(ObjMsgData *data);
+  /// Consume 'batch' as a single httpd work item, broadcasting one frame per
+  /// data, or add it to the batching window
+  int ConsumeBatch(span<ObjMsgData *> batch);
   bool IsConnected();
   void SetConnected(bool connected);
 
+  /// Copy the state of each /ws client, including its queue statistics
+  /// @return the clients
+  vector<ws_client_t> GetClients();
+
   /// Scan for wifi access points
   void WifiScan(void);
 
@@ -70,9 +203,79 @@ protected:
 
   std::list<httpd_uri_t> uris;
 
+  /// /ws clients, by socket; changed only by the httpd task
+  unordered_map<int, ws_connection_t> clients;
+  /// Protects 'clients' from GetClients() while the httpd task changes it
+  SemaphoreHandle_t clientsLock;
+
+  // Send queues
+  uint16_t queueDepth;
+  WsQueuePolicy queuePolicy;
+  uint16_t disconnectDrops;
+  /// Drains the clients again, after a full socket left frames queued
+  esp_timer_handle_t retryTimer;
+  /// Find, or add, client 'fd'; call holding 'clientsLock'
+  ws_connection_t &Client(int fd);
+  /// Queue 'frame' for 'client', applying the queue policy; call holding 'clientsLock'
+  void Enqueue(ws_connection_t &client, ws_queued_t &frame);
+  /// Send each client's queued frames, while its socket has room
+  void Drain();
+  static void WebSockDrain(void *arg);
+  static void RetryTimer(void *arg);
+
+  // Batching
+  uint16_t batchWindowMs;
+  size_t batchBudget;
+  ObjMsgFormat batchFormat;
+  /// Data waiting for the window to end (or, unbatched, for Broadcast())
+  vector<ws_pending_t> pending;
+  size_t pendingBytes;
+  /// Protects 'pending'
+  SemaphoreHandle_t pendingLock;
+  /// Given by the first data of a window
+  SemaphoreHandle_t windowStart;
+  /// Set when 'windowStart' is given, cleared when the window ends;
+  /// protected by 'pendingLock'
+  bool windowOpen;
+  /// Work items for reuse, with their frame capacity; protected by 'pendingLock'
+  vector<ws_work_t *> spareWork;
+  static void BatchTask(void *arg);
+  /// Queue 'pending' to be sent, and clear it; call holding 'pendingLock'
+  /// @param batched: send one frame per client, rather than per data
+  /// @return boolean success
+  bool Broadcast(bool batched);
+  /// Release the frames of 'work', once sent, and keep it for reuse
+  void RecycleWork(ws_work_t *work);
+
+  // Receiving
+  /// Ring of received messages, for ReceiveTask
+  ws_received_t received[WS_RECV_QUEUE_DEPTH];
+  uint16_t receivedHead;
+  uint16_t receivedCount;
+  portMUX_TYPE receivedLock = portMUX_INITIALIZER_UNLOCKED;
+  /// Received message count, for ReceiveTask to wait on
+  SemaphoreHandle_t receivedPending;
+  static void ReceiveTask(void *arg);
+  /// Queue 'message' from client 'fd' to be parsed
+  /// @return false if the queue is full
+  bool PostReceived(int fd, ObjMsgBufferRef &message);
+  /// Parse and produce a received message, or batch of messages
+  /// @param fd: client socket
+  /// @param message: message JSON, or a JSON array of messages
+  void Receive(int fd, string_view message);
+  /// Parse and produce (or handle, if built in) one received message
+  /// @param fd: client socket
+  /// @param message: message JSON
+  void ReceiveMessage(int fd, string_view message);
+
   // Websocket
   static void WebSockAsyncBroadcast(void *arg);
   static esp_err_t WebSockMsgHandler(httpd_req_t *req);
+  /// Replace the subscription of client 'fd' with 'value'
+  /// @param fd: client socket
+  /// @param value: __WS_SUBSCRIBE__ value JSON
+  /// @return false if 'value' is malformed
+  bool Subscribe(int fd, string_view value);
   void SmartConfigStart();
 
 
@@ -82,14 +82,19 @@ static void MessageTask(void *pvParameters)
 {
   ObjMsgDataRef dataRef;
   TickType_t wait = portMAX_DELAY;
+  const uint16_t zoomJoyName = ObjMsgData::InternName(ZOOM_JOY_NAME);
+  // Names of the data built below, interned once rather than per message
+  const uint16_t servoXName = ObjMsgData::InternName(ZOOM_SERVO_X_NAME);
+  const uint16_t xGt0Name = ObjMsgData::InternName(ZOOM_X_GT_0);
+  const uint16_t yGt0Name = ObjMsgData::InternName(ZOOM_Y_GT_0);
 
   for (;;)
   {
     if (transport.Receive(dataRef, wait))
     {
       ObjMsgData *data = dataRef.get();
-      ObjMsgJoystickData *jsd = static_cast<ObjMsgJoystickData *>(data);
-      if (jsd && jsd->GetName().compare(ZOOM_JOY_NAME) == 0)
+      ObjMsgJoystickData *jsd = data->As<ObjMsgJoystickData>();
+      if (jsd && jsd->IsNamed(zoomJoyName))
       {
         // Application processing of the zoom joystick
 
@@ -98,19 +103,18 @@ static void MessageTask(void *pvParameters)
         jsd->GetRawValue(sample);
 
         // Move the servo to the position dictated by the x position
-        ObjMsgServoData servo(jsd->GetOrigin(), ZOOM_SERVO_X_NAME, sample.x);
+        ObjMsgServoData servo(jsd->GetOrigin(), servoXName, sample.x);
         servos.Consume(&servo);
 
         // Rurn on corresponding LED when x / y > 0
-        ObjMsgDataInt x(jsd->GetOrigin(), ZOOM_X_GT_0, sample.x > 0);
+        ObjMsgDataInt x(jsd->GetOrigin(), xGt0Name, sample.x > 0);
         gpio.Consume(&x);
-        ObjMsgDataInt y(jsd->GetOrigin(), ZOOM_Y_GT_0, sample.y > 0);
+        ObjMsgDataInt y(jsd->GetOrigin(), yGt0Name, sample.y > 0);
         gpio.Consume(&y);
       }
-      // Show all of the messages
-      string str;
-      data->Serialize(str);
-      ESP_LOGI(TAG, "(%s) JSON: %s", origins[data->GetOrigin()], str.c_str());
+      // Show all of the messages; the JSON is shared with other consumers
+      ObjMsgBufferRef json = data->Encode(JSON_FORMAT);
+      ESP_LOGI(TAG, "(%s) JSON: %s", origins[data->GetOrigin()], json ? json->c_str() : "");
     }
   }
 }
@@ -120,6 +124,10 @@ static void MessageTask(void *pvParameters)
 //
 extern "C" void app_main(void)
 {
+  // Pool the sampled data types, so producing them does not use the heap
+  ObjMsgJoystickData::ReservePool(2 * MSG_QUEUE_MAX_DEPTH);
+  ObjMsgDataInt::ReservePool(2 * MSG_QUEUE_MAX_DEPTH);
+
   // Configure and start joysticks
   joysticks.Add(PT_JOY_NAME, CHANGE_EVENT,
                 PT_JOY_CHANS[1], PT_JOY_CHANS[0], PT_JOY_PINS[2]);
@@ -143,6 +151,9 @@ extern "C" void app_main(void)
   gpio.Add(ZOOM_Y_GT_0, LED_OUT_PINS[1], POLLING, DEFAULT_GF);
   gpio.Start();
 
+  // Every host has registered its data classes; index them for fast lookup
+  ObjMsgData::dataFactory.Freeze();
+
   xTaskCreate(MessageTask, "MessageTask",
               CONFIG_ESP_MINIMAL_SHARED_STACK_SIZE + 1024, NULL,
               tskIDLE_PRIORITY, &MessageTaskHandle);
@@ -93,14 +93,20 @@ static void MessageTask(void *pvParameters)
 {
   ObjMsgDataRef dataRef;
   TickType_t wait = portMAX_DELAY;
+  const uint16_t zoomJoyName = ObjMsgData::InternName(ZOOM_JOY_NAME);
+  // Names of the data built below, interned once rather than per message
+  const uint16_t servoXName = ObjMsgData::InternName(ZOOM_SERVO_X_NAME);
+  const uint16_t xGt0Name = ObjMsgData::InternName(ZOOM_X_GT_0);
+  const uint16_t yGt0Name = ObjMsgData::InternName(ZOOM_Y_GT_0);
+  const uint16_t sampleName = ObjMsgData::InternName("sample");
 
   for (;;)
   {
     if (transport.Receive(dataRef, wait))
     {
       ObjMsgData *data = dataRef.get();
-      ObjMsgJoystickData *jsd = static_cast<ObjMsgJoystickData *>(data);
-      if (jsd && jsd->GetName().compare(ZOOM_JOY_NAME) == 0)
+      ObjMsgJoystickData *jsd = data->As<ObjMsgJoystickData>();
+      if (jsd && jsd->IsNamed(zoomJoyName))
       {
         // Application processing of the zoom joystick
 
@@ -109,24 +115,23 @@ static void MessageTask(void *pvParameters)
         jsd->GetRawValue(sample);
 
         // Move the servo to the position dictated by the x position
-        ObjMsgServoData servo(jsd->GetOrigin(), ZOOM_SERVO_X_NAME, sample.x);
+        ObjMsgServoData servo(jsd->GetOrigin(), servoXName, sample.x);
         servos.Consume(&servo);
 
         // Rurn on corresponding LED when x / y > 0
-        ObjMsgDataInt x(jsd->GetOrigin(), ZOOM_X_GT_0, sample.x > 0);
+        ObjMsgDataInt x(jsd->GetOrigin(), xGt0Name, sample.x > 0);
         gpio.Consume(&x);
-        ObjMsgDataInt y(jsd->GetOrigin(), ZOOM_Y_GT_0, sample.y > 0);
+        ObjMsgDataInt y(jsd->GetOrigin(), yGt0Name, sample.y > 0);
         gpio.Consume(&y);
       }
-      if (data->GetName().compare("sample") == 0)
+      if (data->IsNamed(sampleName))
       {
         extern void BtnSampleClicked(lv_event_t * e);
         BtnSampleClicked(NULL);
       }
-      // Show all of the messages
-      string str;
-      data->Serialize(str);
-      ESP_LOGI(TAG, "(%s) JSON: %s", origins[data->GetOrigin()], str.c_str());
+      // Show all of the messages; the JSON is shared with other consumers
+      ObjMsgBufferRef json = data->Encode(JSON_FORMAT);
+      ESP_LOGI(TAG, "(%s) JSON: %s", origins[data->GetOrigin()], json ? json->c_str() : "");
     }
   }
 }
@@ -136,17 +141,17 @@ static void MessageTask(void *pvParameters)
 //
 bool LvglJoystickComsumer(LvglHost *host, ObjMsgData *data)
 {
-  ObjMsgJoystickData *jsd = static_cast<ObjMsgJoystickData *>(data);
+  ObjMsgJoystickData *jsd = data->As<ObjMsgJoystickData>();
   if (jsd)
   {
     joystick_sample_t sample;
     jsd->GetRawValue(sample);
 
     // Consume sample.x as <name>x
-    ObjMsgDataInt x(jsd->GetOrigin(), (jsd->GetName() + "x").c_str(), sample.x);
+    ObjMsgDataInt x(jsd->GetOrigin(), (string(jsd->GetName()) + "x").c_str(), sample.x);
     host->Consume(&x);
     // Consume sample.y as <name>y
-    ObjMsgDataInt y(jsd->GetOrigin(), (jsd->GetName() + "y").c_str(), sample.y);
+    ObjMsgDataInt y(jsd->GetOrigin(), (string(jsd->GetName()) + "y").c_str(), sample.y);
     host->Consume(&y);
 
     return true;
@@ -163,6 +168,12 @@ bool LvglJoystickComsumer(LvglHost *host, ObjMsgData *data)
 //
 void MessagingInit()
 {
+  // Pool the sampled data types, so producing them does not use the heap
+  ObjMsgJoystickData::ReservePool(2 * MSG_QUEUE_MAX_DEPTH);
+  ObjMsgDataInt::ReservePool(2 * MSG_QUEUE_MAX_DEPTH);
+  // Pool the encodings shared by the websocket and logging
+  ObjMsgBuffer::ReservePool(4 * MSG_QUEUE_MAX_DEPTH, 64);
+
   // Configure and start joysticks
   joysticks.Add(PT_JOY_NAME, CHANGE_EVENT,
                 PT_JOY_CHANS[1], PT_JOY_CHANS[0], PT_JOY_PINS[2]);
@@ -206,5 +217,8 @@ transport.AddForward(ORIGIN_ADC, &lvgl);
   // Have transport forward messages to ws
   transport.AddForward(ORIGIN_JOYSTICK, &ws);
   transport.AddForward(ORIGIN_ADC, &ws);
-  
+  // Routing is complete; compile it for fast forwarding
+  transport.Freeze();
+  // Every host has registered its data classes; index them for fast lookup
+  ObjMsgData::dataFactory.Freeze();
 }
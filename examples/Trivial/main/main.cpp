@@ -36,24 +36,25 @@ static void MessageTask(void *pvParameters)
 {
   ObjMsgDataRef dataRef;
   TickType_t wait = portMAX_DELAY;
+  const uint16_t bootBtnName = ObjMsgData::InternName("bootBtn");
+  const uint16_t ledName = ObjMsgData::InternName("builtinled");
 
   for (;;)
   {
     if (transport.Receive(dataRef, wait))
     {
       ObjMsgData *data = dataRef.get();
-      if (data->GetName().compare("bootBtn") == 0)
+      if (data->IsNamed(bootBtnName))
       {
         // Send 'bootBtn' value to 'builtinLed'
         int value;
         data->GetValue(value);
-        ObjMsgDataInt led(data->GetOrigin(), "builtinled", value);
+        ObjMsgDataInt led(data->GetOrigin(), ledName, value);
         gpio.Consume(&led);
       }
-      // Show all of the messages
-      string str;
-      data->Serialize(str);
-      ESP_LOGI(TAG, "(%s) JSON: %s", origins[data->GetOrigin()], str.c_str());
+      // Show all of the messages; the JSON is shared with other consumers
+      ObjMsgBufferRef json = data->Encode(JSON_FORMAT);
+      ESP_LOGI(TAG, "(%s) JSON: %s", origins[data->GetOrigin()], json ? json->c_str() : "");
     }
   }
 }
@@ -69,6 +70,9 @@ extern "C" void app_main(void)
     NEG_EVENT_GF | POS_EVENT_GF | IS_INPUT_GF | INVERTED_GF);
   gpio.Start();
 
+  // Every host has registered its data classes; index them for fast lookup
+  ObjMsgData::dataFactory.Freeze();
+
   xTaskCreate(MessageTask, "MessageTask",
     CONFIG_ESP_MINIMAL_SHARED_STACK_SIZE + 1024, NULL,
     tskIDLE_PRIORITY, &MessageTaskHandle);
@@ -0,0 +1,65 @@
+#pragma once
+/*
+ * Host benchmark support: timing, heap allocation counts and reporting
+ *
+ * Allocations are counted by replacing global operator new (bench.cpp), so
+ * they include the C++ heap only, not malloc() calls.
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+
+/// Get the number of operator new allocations so far
+/// @return count
+uint64_t BenchAllocations();
+
+/// Check for --quick (as run by ctest): few iterations, a smoke test only
+/// @return true if quick
+inline bool BenchQuick(int argc, char **argv)
+{
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "--quick") == 0)
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+/// Measures elapsed time and allocations from construction (or Restart())
+class BenchRun
+{
+  std::chrono::steady_clock::time_point start;
+  uint64_t allocations;
+
+public:
+  BenchRun() { Restart(); }
+
+  void Restart()
+  {
+    allocations = BenchAllocations();
+    start = std::chrono::steady_clock::now();
+  }
+
+  /// @return microseconds since start
+  double ElapsedUs()
+  {
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+  }
+
+  /// @return allocations since start
+  uint64_t Allocations() { return BenchAllocations() - allocations; }
+
+  /// Print one result line: name, throughput, time and allocations per item
+  /// @param name: what was measured
+  /// @param items: number of items (messages, encodings...) processed
+  void Report(const char *name, uint64_t items)
+  {
+    double us = ElapsedUs();
+    uint64_t allocated = Allocations();
+    printf("%-40s %12.0f /s %10.3f us %8.3f allocs\n", name, items / us * 1e6, us / items,
+           (double)allocated / items);
+  }
+};
@@ -0,0 +1,132 @@
+/*
+ * Binary (MessagePack) encoding against JSON: encoded size, and encode and
+ * decode throughput, for typical messages
+ *
+ * JSON is encoded with Serialize(string&) and the non-allocating
+ * ObjMsgJsonWriter, and decoded with ObjMsgData::Deserialize(); binary with
+ * SerializeBinary() into a reused buffer and ObjMsgData::DeserializeBinary().
+ * Each message is checked to decode back to the same value. Last, JSON for
+ * several consumers of each message is serialized by each, then shared
+ * through Encode().
+ */
+#include "ObjMsg.h"
+#include "ObjMsgJoystickData.h"
+#include "bench.h"
+#include "check.h"
+
+#define ORIGIN 1
+
+/// Encode and decode 'data' 'count' times each way, and report
+static void Run(ObjMsgDataRef data, uint32_t count)
+{
+  string name(data->GetName());
+  string expected;
+  data->GetValue(expected);
+  char json[256];
+  vector<uint8_t> binary;
+  binary.reserve(256);
+
+  // Sizes, and a round trip each way
+  ObjMsgJsonWriter writer(json, sizeof(json));
+  CHECK(data->Serialize(writer));
+  data->SerializeBinary(binary);
+  string value;
+  ObjMsgDataRef decoded = ObjMsgData::Deserialize(ORIGIN, json);
+  CHECK(decoded && decoded->GetValue(value) == data->GetValue(expected) && value == expected);
+  decoded = ObjMsgData::DeserializeBinary(ORIGIN, binary.data(), binary.size());
+  CHECK(decoded && decoded->GetValue(value) == data->GetValue(expected) && value == expected);
+  decoded.reset();
+  printf("%s: JSON %zu bytes, binary %zu bytes\n", name.c_str(), strlen(json), binary.size());
+
+  BenchRun run;
+  for (uint32_t i = 0; i < count; i++)
+  {
+    string json;
+    data->Serialize(json);
+  }
+  run.Report("  JSON encode, string", count);
+
+  run.Restart();
+  for (uint32_t i = 0; i < count; i++)
+  {
+    ObjMsgJsonWriter writer(json, sizeof(json));
+    data->Serialize(writer);
+  }
+  run.Report("  JSON encode, writer", count);
+
+  run.Restart();
+  for (uint32_t i = 0; i < count; i++)
+  {
+    binary.clear();
+    data->SerializeBinary(binary);
+  }
+  run.Report("  binary encode", count);
+
+  run.Restart();
+  for (uint32_t i = 0; i < count; i++)
+  {
+    ObjMsgDataRef decoded = ObjMsgData::Deserialize(ORIGIN, json);
+  }
+  run.Report("  JSON decode", count);
+
+  run.Restart();
+  for (uint32_t i = 0; i < count; i++)
+  {
+    ObjMsgDataRef decoded = ObjMsgData::DeserializeBinary(ORIGIN, binary.data(), binary.size());
+  }
+  run.Report("  binary decode", count);
+}
+
+#define CONSUMERS 3 ///< Consumers of each message, such as websocket and logging
+
+/// New data each message, as produced, encoded as JSON by CONSUMERS consumers
+/// each serializing, then sharing the Encode() cache
+static void RunShared(uint32_t count)
+{
+  char json[256];
+  BenchRun run;
+  for (uint32_t i = 0; i < count; i++)
+  {
+    ObjMsgDataRef data = ObjMsgDataInt::Create(ORIGIN, "zoom", i);
+    for (int consumer = 0; consumer < CONSUMERS; consumer++)
+    {
+      ObjMsgJsonWriter writer(json, sizeof(json));
+      data->Serialize(writer);
+    }
+  }
+  run.Report("  Serialize() by each consumer", count);
+
+  run.Restart();
+  for (uint32_t i = 0; i < count; i++)
+  {
+    ObjMsgDataRef data = ObjMsgDataInt::Create(ORIGIN, "zoom", i);
+    for (int consumer = 0; consumer < CONSUMERS; consumer++)
+    {
+      ObjMsgBufferRef encoded = data->Encode(JSON_FORMAT);
+    }
+  }
+  run.Report("  Encode(), shared", count);
+}
+
+int main(int argc, char **argv)
+{
+  uint32_t count = BenchQuick(argc, argv) ? 100 : 500000;
+  ObjMsgData::RegisterClass(ORIGIN, "pantilt", ObjMsgJoystickData::Create);
+  ObjMsgData::RegisterClass(ORIGIN, "zoom", ObjMsgDataInt::Create);
+  ObjMsgData::RegisterClass(ORIGIN, "gain", ObjMsgDataFloat::Create);
+  ObjMsgData::RegisterClass(ORIGIN, "scene", ObjMsgDataString::Create);
+  ObjMsgJoystickData::ReservePool(4);
+  ObjMsgDataInt::ReservePool(4);
+  ObjMsgDataFloat::ReservePool(4);
+  ObjMsgDataString::ReservePool(4);
+
+  printf("%u of each\n", (unsigned)count);
+  joystick_sample_t sample = {-120, 345, 1};
+  Run(ObjMsgJoystickData::Create(ORIGIN, "pantilt", sample), count);
+  Run(ObjMsgDataInt::Create(ORIGIN, "zoom", 1234), count);
+  Run(ObjMsgDataFloat::Create(ORIGIN, "gain", 0.75), count);
+  Run(ObjMsgDataString::Create(ORIGIN, "scene", "Camera 2 wide"), count);
+  printf("int, created and encoded as JSON for %d consumers\n", CONSUMERS);
+  RunShared(count);
+  return 0;
+}
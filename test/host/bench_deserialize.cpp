@@ -0,0 +1,118 @@
+/*
+ * ObjMsgData::Deserialize() of {"name","value"} messages, in one pass with
+ * ObjMsgJsonReader, over a corpus of joystick, slider and string messages
+ *
+ * With a real cJSON (CJSON_DIR, or ESP-IDF's via IDF_PATH), the cJSON DOM
+ * path Deserialize() replaced is timed as the baseline; the stub cJSON
+ * cannot parse, so without one only the reader is timed. The split alone
+ * (ObjMsgJsonReader finding name and value) is reported too.
+ */
+#include "ObjMsg.h"
+#include "ObjMsgJoystickData.h"
+#include "bench.h"
+#include "check.h"
+
+#define ORIGIN 1
+
+/// Messages as received from websocket clients and LVGL
+static const char *corpus[] = {
+  "{\"name\":\"pantilt\",\"value\":{\"x\":-120,\"y\":345,\"up\":1}}",
+  "{\"name\":\"pantilt\",\"value\":{\"x\":0,\"y\":0,\"up\":0}}",
+  "{\"name\":\"zoom_slider\",\"value\":512}",
+  "{\"value\":-64,\"name\":\"zoom_slider\"}",
+  "{\"name\":\"scene\",\"value\":\"Camera 2 wide\"}",
+  "{\"name\":\"scene\",\"value\":\"Tab\\there, \\\"quoted\\\" \\u00e9\"}",
+};
+#define CORPUS_SIZE (sizeof(corpus) / sizeof(corpus[0]))
+
+#ifdef OBJMSG_HOST_CJSON
+/// The replaced path: parse to a cJSON DOM, then create and populate from it
+static ObjMsgDataRef LegacyDeserialize(uint16_t origin, const char *json)
+{
+  ObjMsgDataRef data;
+  cJSON *root = cJSON_Parse(json);
+  if (root)
+  {
+    cJSON *jsonName = cJSON_GetObjectItemCaseSensitive(root, "name");
+    if (jsonName)
+    {
+      data = ObjMsgData::dataFactory.Create(origin, cJSON_GetStringValue(jsonName));
+      if (data && !data->DeserializeValue(root))
+      {
+        data.reset();
+      }
+    }
+    cJSON_Delete(root);
+  }
+  return data;
+}
+#endif
+
+int main(int argc, char **argv)
+{
+  uint32_t rounds = BenchQuick(argc, argv) ? 100 : 200000;
+  uint32_t messages = rounds * CORPUS_SIZE;
+  ObjMsgData::RegisterClass(ORIGIN, "pantilt", ObjMsgJoystickData::Create);
+  ObjMsgData::RegisterClass(ORIGIN, "zoom_slider", ObjMsgDataInt::Create);
+  ObjMsgData::RegisterClass(ORIGIN, "scene", ObjMsgDataString::Create);
+  ObjMsgData::dataFactory.Freeze();
+  ObjMsgJoystickData::Pool().Reserve(4);
+  ObjMsgDataInt::Pool().Reserve(4);
+  ObjMsgDataString::Pool().Reserve(4);
+
+  // Every message decodes to the registered class
+  for (const char *json : corpus)
+  {
+    ObjMsgDataRef data = ObjMsgData::Deserialize(ORIGIN, json);
+    CHECK(data && data->Is<ObjMsgDataString>() == (strstr(json, "scene") != NULL));
+#ifdef OBJMSG_HOST_CJSON
+    ObjMsgDataRef legacy = LegacyDeserialize(ORIGIN, json);
+    string value, legacyValue;
+    CHECK(legacy && data->GetValue(value) && legacy->GetValue(legacyValue) && value == legacyValue);
+#endif
+  }
+
+  printf("%u messages, corpus of %zu\n", (unsigned)messages, CORPUS_SIZE);
+
+  BenchRun run;
+  size_t found = 0;
+  for (uint32_t round = 0; round < rounds; round++)
+  {
+    for (const char *json : corpus)
+    {
+      ObjMsgJsonReader reader(json);
+      string_view key, item;
+      while (reader.Next(key, item))
+      {
+        ++found;
+      }
+    }
+  }
+  run.Report("ObjMsgJsonReader split only", messages);
+  CHECK(found == 2 * messages);
+
+  run.Restart();
+  for (uint32_t round = 0; round < rounds; round++)
+  {
+    for (const char *json : corpus)
+    {
+      ObjMsgDataRef data = ObjMsgData::Deserialize(ORIGIN, json);
+    }
+  }
+  run.Report("Deserialize(), ObjMsgJsonReader", messages);
+
+#ifdef OBJMSG_HOST_CJSON
+  run.Restart();
+  for (uint32_t round = 0; round < rounds; round++)
+  {
+    for (const char *json : corpus)
+    {
+      ObjMsgDataRef data = LegacyDeserialize(ORIGIN, json);
+    }
+  }
+  run.Report("cJSON DOM (replaced)", messages);
+#else
+  printf("cJSON DOM baseline skipped: set CJSON_DIR to a cJSON source directory\n");
+#endif
+  return 0;
+}
@@ -0,0 +1,123 @@
+/*
+ * Forward() cost against the number of consumers of an origin: routing
+ * frozen into the flat origin indexed table, unfrozen (the unordered_map of
+ * vectors AddForward() builds), and the unordered_map of lists Forward()
+ * used before
+ *
+ * Consumers consume on the calling task, and count what they are handed, so
+ * the time is routing plus a virtual call each. The data has no topic
+ * subscribers, the common case, which frozen routing hands straight to the
+ * consumers Freeze() resolved.
+ */
+#include "ObjMsg.h"
+#include "bench.h"
+#include "check.h"
+
+#define ORIGINS 32
+
+class CountingHost : public ObjMsgHost
+{
+public:
+  uint64_t consumed;
+
+  CountingHost(ObjMsgTransport *transport, uint16_t origin)
+      : ObjMsgHost(transport, "COUNT", origin), consumed(0) {}
+
+  bool Consume(ObjMsgData *data) override
+  {
+    ++consumed;
+    return true;
+  }
+
+  bool Start() override { return true; }
+};
+
+static unordered_map<int, list<ObjMsgHost *>> legacyForwards;
+
+static void LegacyForward(ObjMsgData *data)
+{
+  unordered_map<int, list<ObjMsgHost *>>::iterator found = legacyForwards.find(data->GetOrigin());
+  if (found != legacyForwards.end())
+  {
+    for (ObjMsgHost *fwd : found->second)
+    {
+      if (!data->IsFrom(fwd->GetOrigin()))
+      {
+        fwd->Consume(data);
+      }
+    }
+  }
+}
+
+int main(int argc, char **argv)
+{
+  uint32_t messages = BenchQuick(argc, argv) ? 1000 : 2000000;
+  static const int consumerCounts[] = {1, 4, 16};
+  vector<CountingHost *> hosts;
+  for (int i = 0; i < 16; i++)
+  {
+    hosts.push_back(new CountingHost(NULL, ORIGINS + i));
+  }
+  // Spread forwards over every origin, so the tables are not trivially small
+  vector<ObjMsgDataRef> levels;
+  for (int origin = 0; origin < ORIGINS; origin++)
+  {
+    levels.push_back(ObjMsgDataInt::Create(origin, "level", origin));
+  }
+
+  printf("%u messages, %d origins\n", (unsigned)messages, ORIGINS);
+
+  for (int consumers : consumerCounts)
+  {
+    ObjMsgTransport unfrozen(4);
+    ObjMsgTransport frozen(4);
+    legacyForwards.clear();
+    for (int origin = 0; origin < ORIGINS; origin++)
+    {
+      for (int i = 0; i < consumers; i++)
+      {
+        unfrozen.AddForward(origin, hosts[i]);
+        frozen.AddForward(origin, hosts[i]);
+        legacyForwards[origin].push_back(hosts[i]);
+      }
+    }
+    frozen.Freeze();
+
+    char name[64];
+    BenchRun run;
+    for (uint32_t i = 0; i < messages; i++)
+    {
+      frozen.Forward(levels[i % ORIGINS]);
+    }
+    snprintf(name, sizeof(name), "frozen, %d consumers", consumers);
+    run.Report(name, messages);
+
+    run.Restart();
+    for (uint32_t i = 0; i < messages; i++)
+    {
+      unfrozen.Forward(levels[i % ORIGINS]);
+    }
+    snprintf(name, sizeof(name), "unfrozen, %d consumers", consumers);
+    run.Report(name, messages);
+
+    run.Restart();
+    for (uint32_t i = 0; i < messages; i++)
+    {
+      LegacyForward(levels[i % ORIGINS].get());
+    }
+    snprintf(name, sizeof(name), "map of lists, %d consumers", consumers);
+    run.Report(name, messages);
+  }
+
+  // Each path delivers every message once to each of its consumers
+  for (int i = 0; i < (int)hosts.size(); i++)
+  {
+    uint64_t expected = 0;
+    for (int consumers : consumerCounts)
+    {
+      expected += i < consumers ? (uint64_t)messages * 3 : 0;
+    }
+    CHECK(hosts[i]->consumed == expected);
+  }
+  return 0;
+}
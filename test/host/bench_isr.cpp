@@ -0,0 +1,107 @@
+/*
+ * GPIO edge to Receive() latency: GpioHost's isr_handler sending pooled data
+ * with SendFromISR(), against the path it replaced (the ISR queues the port
+ * to an input task, which allocates data and Send()s it)
+ *
+ * The main thread plays the interrupt: it sets the pin level, stamps the
+ * edge and calls the handler, then waits for the receiving task to get the
+ * data before the next edge. Times are host thread wake ups, so compare the
+ * paths rather than reading them as device figures; allocation counts carry
+ * over to the device.
+ */
+#include "GpioHost.h"
+#include "bench.h"
+#include "check.h"
+#include <atomic>
+
+#define DEPTH 8
+#define ORIGIN_GPIO 2
+
+static ObjMsgTransport transport(DEPTH);
+static std::atomic<int64_t> edgeNs;
+static std::atomic<uint32_t> received;
+static int64_t latencyTotalNs;
+static int64_t latencyMaxNs;
+
+static int64_t NowNs()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/// Receive data, recording the time since the edge
+static void ReceiverTask(void *arg)
+{
+  ObjMsgDataRef data;
+  for (;;)
+  {
+    if (transport.Receive(data, portMAX_DELAY))
+    {
+      int64_t latency = NowNs() - edgeNs;
+      latencyTotalNs += latency;
+      latencyMaxNs = std::max(latencyMaxNs, latency);
+      // Release pooled data before the next edge
+      data.reset();
+      ++received;
+    }
+  }
+}
+
+/// The replaced path: isr_handler queues the level, input_task creates data
+static QueueHandle_t eventQueue;
+
+static void LegacyIsr(void *arg)
+{
+  int level = gpio_get_level(GPIO_NUM_2);
+  xQueueSendFromISR(eventQueue, &level, NULL);
+}
+
+static void LegacyInputTask(void *arg)
+{
+  int level;
+  for (;;)
+  {
+    if (xQueueReceive(eventQueue, &level, portMAX_DELAY))
+    {
+      transport.Send(ObjMsgGpioData::Create(ORIGIN_GPIO, "in", level), NORMAL_PRIORITY, false, BLOCK_OVERFLOW);
+    }
+  }
+}
+
+/// Raise 'edges' edges through 'isr', one at a time, and report latency
+static void Run(const char *name, uint32_t edges, gpio_isr_t isr, void *arg)
+{
+  latencyTotalNs = latencyMaxNs = 0;
+  received = 0;
+  BenchRun run;
+  for (uint32_t i = 0; i < edges; i++)
+  {
+    stub_gpio_level = !stub_gpio_level;
+    edgeNs = NowNs();
+    isr(arg);
+    while (received <= i)
+    {
+      std::this_thread::yield();
+    }
+  }
+  uint64_t allocated = run.Allocations();
+  printf("%-40s %10.3f us mean %10.3f us max %8.3f allocs\n", name, latencyTotalNs / 1e3 / edges,
+         latencyMaxNs / 1e3, (double)allocated / edges);
+}
+
+int main(int argc, char **argv)
+{
+  uint32_t edges = BenchQuick(argc, argv) ? 100 : 20000;
+  GpioHost gpio(&transport, ORIGIN_GPIO);
+  gpio.Add("in", GPIO_NUM_2, CHANGE_EVENT, IS_INPUT_GF | POS_EVENT_GF | NEG_EVENT_GF);
+  CHECK(gpio.Start() && stub_gpio_isr);
+  transport.Freeze();
+  eventQueue = xQueueCreate(10, sizeof(int));
+  xTaskCreate(ReceiverTask, "receiver", 4096, NULL, 10, NULL);
+  xTaskCreate(LegacyInputTask, "gpio_input_task", 4096, NULL, 10, NULL);
+
+  printf("%u edges\n", (unsigned)edges);
+  Run("SendFromISR, pooled data", edges, stub_gpio_isr, stub_gpio_isr_arg);
+  Run("input task, Create() and Send()", edges, LegacyIsr, NULL);
+  return 0;
+}
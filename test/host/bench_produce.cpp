@@ -0,0 +1,193 @@
+/*
+ * ObjMsgDataRef, the intrusive counted reference, against the std::shared_ptr
+ * it replaced (allocate_shared from a block pool, as ObjMsgPoolAllocator did)
+ *
+ * Each reference type is timed copying and releasing a reference, and
+ * carrying data from creation through a ring of slots to Consume() and
+ * release; the ring is the same for both, so only the reference differs.
+ * The whole Produce() to Consume() path through ObjMsgTransport is reported
+ * for scale.
+ */
+#include "ObjMsg.h"
+#include "bench.h"
+#include "check.h"
+
+#define DEPTH 16
+
+/// As ObjMsgPoolAllocator was, for the shared_ptr baseline
+static ObjMsgBlockPool sharedPool;
+
+template <class U>
+class SharedPoolAllocator
+{
+public:
+  typedef U value_type;
+
+  SharedPoolAllocator() {}
+  template <class V>
+  SharedPoolAllocator(const SharedPoolAllocator<V>&) {}
+
+  U* allocate(size_t n) { return (U*)sharedPool.Allocate(n * sizeof(U)); }
+  void deallocate(U* p, size_t n) { sharedPool.Free(p); }
+
+  template <class V>
+  bool operator==(const SharedPoolAllocator<V>&) const { return true; }
+  template <class V>
+  bool operator!=(const SharedPoolAllocator<V>&) const { return false; }
+};
+
+typedef std::shared_ptr<ObjMsgData> SharedDataRef;
+
+/// Counts what it consumes
+class CountingHost : public ObjMsgHost
+{
+public:
+  uint64_t consumed;
+
+  CountingHost(ObjMsgTransport *transport, uint16_t origin)
+      : ObjMsgHost(transport, "COUNT", origin), consumed(0) {}
+
+  bool Consume(ObjMsgData *data) override
+  {
+    ++consumed;
+    return true;
+  }
+
+  bool Start() override { return true; }
+};
+
+/// A ring of 'Ref' slots under a critical section, as the transport's lanes
+template <class Ref>
+class Ring
+{
+  Ref slots[DEPTH];
+  uint16_t head = 0;
+  uint16_t count = 0;
+  portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+
+public:
+  bool Push(Ref &&data)
+  {
+    portENTER_CRITICAL(&lock);
+    bool result = count < DEPTH;
+    if (result)
+    {
+      slots[(head + count++) % DEPTH] = std::move(data);
+    }
+    portEXIT_CRITICAL(&lock);
+    return result;
+  }
+
+  bool Pop(Ref &data)
+  {
+    portENTER_CRITICAL(&lock);
+    bool result = count > 0;
+    if (result)
+    {
+      data = std::move(slots[head]);
+      head = (head + 1) % DEPTH;
+      --count;
+    }
+    portEXIT_CRITICAL(&lock);
+    return result;
+  }
+};
+
+/// Keeps the process multithreaded, as the device always is; libstdc++'s
+/// shared_ptr skips its atomic operations in a single threaded process
+static void IdleTask(void *arg)
+{
+  for (;;)
+  {
+    vTaskDelay(1000);
+  }
+}
+
+static ObjMsgDataRef CreateRef(uint16_t nameId, int value)
+{
+  return ObjMsgDataRef(new ObjMsgDataInt(1, nameId, value));
+}
+
+static SharedDataRef CreateShared(uint16_t nameId, int value)
+{
+  return std::allocate_shared<ObjMsgDataInt>(SharedPoolAllocator<ObjMsgDataInt>(), 1, nameId, value);
+}
+
+/// Copy and release a reference to 'data' 'count' times
+template <class Ref>
+static void CopyRelease(const char *name, const Ref &data, uint32_t count)
+{
+  BenchRun run;
+  for (uint32_t i = 0; i < count; i++)
+  {
+    Ref copy = data;
+    // Keep the copy from being optimized away
+    asm volatile("" : : "r"(copy.get()) : "memory");
+  }
+  run.Report(name, count);
+  CHECK(data.use_count() == 1);
+}
+
+/// Create, ring, Consume() and release 'bursts' bursts of DEPTH data
+template <class Ref, class F>
+static void CreateConsume(const char *name, F create, uint16_t nameId, CountingHost &consumer, uint32_t bursts)
+{
+  Ring<Ref> ring;
+  Ref data;
+  consumer.consumed = 0;
+  BenchRun run;
+  for (uint32_t burst = 0; burst < bursts; burst++)
+  {
+    for (int i = 0; i < DEPTH; i++)
+    {
+      ring.Push(create(nameId, i));
+    }
+    while (ring.Pop(data))
+    {
+      consumer.Consume(data.get());
+      data.reset();
+    }
+  }
+  run.Report(name, bursts * DEPTH);
+  CHECK(consumer.consumed == (uint64_t)bursts * DEPTH);
+}
+
+int main(int argc, char **argv)
+{
+  uint32_t bursts = BenchQuick(argc, argv) ? 100 : 200000;
+  uint32_t messages = bursts * DEPTH;
+  xTaskCreate(IdleTask, "idle", 1024, NULL, 0, NULL);
+  ObjMsgDataInt::Pool().Reserve(DEPTH * 2);
+  sharedPool.Reserve(DEPTH * 2);
+  uint16_t nameId = ObjMsgData::InternName("level");
+  ObjMsgTransport transport(DEPTH);
+  CountingHost producer(&transport, 1), consumer(&transport, 2);
+  transport.AddForward(1, &consumer);
+  transport.Freeze();
+
+  printf("%u messages, ObjMsgDataRef %zu bytes, shared_ptr %zu bytes\n", (unsigned)messages,
+         sizeof(ObjMsgDataRef), sizeof(SharedDataRef));
+
+  CopyRelease("ObjMsgDataRef copy, release", CreateRef(nameId, 0), messages);
+  CopyRelease("shared_ptr copy, release", CreateShared(nameId, 0), messages);
+  CreateConsume<ObjMsgDataRef>("ObjMsgDataRef create to release", CreateRef, nameId, consumer, bursts);
+  CreateConsume<SharedDataRef>("shared_ptr create to release", CreateShared, nameId, consumer, bursts);
+
+  consumer.consumed = 0;
+  ObjMsgDataRef received;
+  BenchRun run;
+  for (uint32_t burst = 0; burst < bursts; burst++)
+  {
+    for (int i = 0; i < DEPTH; i++)
+    {
+      producer.Produce(CreateRef(nameId, i));
+    }
+    while (transport.Receive(received, 0))
+    {
+    }
+  }
+  received.reset();
+  run.Report("Produce() to Consume(), ObjMsgTransport", messages);
+  CHECK(consumer.consumed == messages);
+  return 0;
+}
@@ -0,0 +1,171 @@
+/*
+ * Transport throughput and allocations: the slot ring, against the path it
+ * replaced (LegacyTransport, as ObjMsgTransport was: a heap allocated
+ * ObjMessage per Send(), passed by pointer through a FreeRTOS queue and
+ * deleted by Receive(), which forwards through an unordered_map of lists)
+ *
+ * Messages are sent in bursts of the queue depth, then received, first on
+ * one task (the transport's own cost) and then from a producer task to the
+ * receiving task. Times are host times; allocation counts carry over to the
+ * device, where each heap operation also takes the heap lock.
+ */
+#include "ObjMsg.h"
+#include "bench.h"
+
+#define DEPTH 32
+
+class LegacyTransport
+{
+  class ObjMessage
+  {
+  public:
+    ObjMessage(ObjMsgDataRef dataRef) { _p = dataRef; }
+    ObjMsgDataRef &dataRef() { return _p; }
+
+  private:
+    ObjMsgDataRef _p;
+  };
+  QueueHandle_t message_queue;
+  unordered_map<int, list<ObjMsgHost *>> forwards;
+
+public:
+  LegacyTransport(uint16_t message_queue_depth)
+  {
+    message_queue = xQueueCreate(message_queue_depth, sizeof(ObjMessage *));
+  }
+
+  bool Send(ObjMsgDataRef dataRef, TickType_t xTicksToWait = 0)
+  {
+    ObjMessage *msg = new ObjMessage(dataRef);
+    bool result = xQueueSend(message_queue, &msg, xTicksToWait) ? true : false;
+    if (!result)
+    {
+      delete msg;
+    }
+    return result;
+  }
+
+  void Forward(ObjMsgData *data)
+  {
+    unordered_map<int, list<ObjMsgHost *>>::iterator found = forwards.find(data->GetOrigin());
+    if (found != forwards.end())
+    {
+      for (ObjMsgHost *fwd : found->second)
+      {
+        if (!data->IsFrom(fwd->GetOrigin()))
+        {
+          fwd->Consume(data);
+        }
+      }
+    }
+  }
+
+  bool Receive(ObjMsgDataRef &dataRef, TickType_t xTicksToWait)
+  {
+    ObjMessage *msg;
+    bool result = xQueueReceive(message_queue, &msg, xTicksToWait) ? true : false;
+    if (result)
+    {
+      dataRef = msg->dataRef();
+      Forward(dataRef.get());
+      delete msg;
+    }
+    return result;
+  }
+};
+
+static ObjMsgTransport transport(DEPTH);
+static LegacyTransport legacy(DEPTH);
+static ObjMsgDataRef level;
+/// Given by the receiving task when it is ready for the next burst
+static SemaphoreHandle_t ready;
+
+static void RingProducer(void *arg)
+{
+  uint32_t bursts = *(uint32_t *)arg;
+  for (uint32_t burst = 0; burst < bursts; burst++)
+  {
+    xSemaphoreTake(ready, portMAX_DELAY);
+    for (int i = 0; i < DEPTH; i++)
+    {
+      transport.Send(level);
+    }
+  }
+}
+
+static void LegacyProducer(void *arg)
+{
+  uint32_t bursts = *(uint32_t *)arg;
+  for (uint32_t burst = 0; burst < bursts; burst++)
+  {
+    xSemaphoreTake(ready, portMAX_DELAY);
+    for (int i = 0; i < DEPTH; i++)
+    {
+      legacy.Send(level);
+    }
+  }
+}
+
+int main(int argc, char **argv)
+{
+  uint32_t bursts = BenchQuick(argc, argv) ? 100 : 100000;
+  uint32_t messages = bursts * DEPTH;
+  level = ObjMsgDataInt::Create(1, "level", 0);
+  ready = xSemaphoreCreateBinary();
+  ObjMsgDataRef received;
+
+  printf("%u messages, queue depth %d\n", (unsigned)messages, DEPTH);
+
+  BenchRun run;
+  for (uint32_t burst = 0; burst < bursts; burst++)
+  {
+    for (int i = 0; i < DEPTH; i++)
+    {
+      transport.Send(level);
+    }
+    for (int i = 0; i < DEPTH; i++)
+    {
+      transport.Receive(received, 0);
+    }
+  }
+  run.Report("slot ring, one task", messages);
+
+  run.Restart();
+  for (uint32_t burst = 0; burst < bursts; burst++)
+  {
+    for (int i = 0; i < DEPTH; i++)
+    {
+      legacy.Send(level);
+    }
+    for (int i = 0; i < DEPTH; i++)
+    {
+      legacy.Receive(received, 0);
+    }
+  }
+  run.Report("heap ObjMessage, one task", messages);
+
+  run.Restart();
+  xTaskCreate(RingProducer, "producer", 4096, &bursts, 5, NULL);
+  for (uint32_t burst = 0; burst < bursts; burst++)
+  {
+    xSemaphoreGive(ready);
+    for (int i = 0; i < DEPTH; i++)
+    {
+      transport.Receive(received, portMAX_DELAY);
+    }
+  }
+  run.Report("slot ring, producer task", messages);
+
+  run.Restart();
+  xTaskCreate(LegacyProducer, "producer", 4096, &bursts, 5, NULL);
+  for (uint32_t burst = 0; burst < bursts; burst++)
+  {
+    xSemaphoreGive(ready);
+    for (int i = 0; i < DEPTH; i++)
+    {
+      legacy.Receive(received, portMAX_DELAY);
+    }
+  }
+  run.Report("heap ObjMessage, producer task", messages);
+  return 0;
+}
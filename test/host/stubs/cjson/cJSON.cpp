@@ -0,0 +1,17 @@
+#include "cJSON.h"
+
+cJSON *cJSON_Parse(const char *value) { return NULL; }
+cJSON *cJSON_ParseWithLength(const char *value, size_t length) { return NULL; }
+void cJSON_Delete(cJSON *item) {}
+char *cJSON_Print(const cJSON *item) { return NULL; }
+char *cJSON_PrintUnformatted(const cJSON *item) { return NULL; }
+int cJSON_PrintPreallocated(cJSON *item, char *buffer, const int length, const int format) { return 0; }
+void cJSON_free(void *object) {}
+cJSON *cJSON_GetObjectItem(const cJSON *object, const char *string) { return NULL; }
+cJSON *cJSON_GetObjectItemCaseSensitive(const cJSON *object, const char *string) { return NULL; }
+char *cJSON_GetStringValue(const cJSON *item) { return NULL; }
+double cJSON_GetNumberValue(const cJSON *item) { return 0; }
+cJSON *cJSON_CreateObject(void) { return NULL; }
+int cJSON_AddItemToObject(cJSON *object, const char *string, cJSON *item) { return 0; }
+cJSON *cJSON_AddNumberToObject(cJSON *object, const char *name, const double number) { return NULL; }
+cJSON *cJSON_AddStringToObject(cJSON *object, const char *name, const char *string) { return NULL; }
@@ -0,0 +1,46 @@
+#pragma once
+/*
+ * Stand-in for the cJSON subset used by ObjMsg, when no cJSON sources are
+ * configured (see CJSON_DIR): parsing fails and nothing is built, so only
+ * the allocation free JSON reader and writer paths work
+ */
+#include <stddef.h>
+
+typedef struct cJSON
+{
+  struct cJSON *next;
+  struct cJSON *prev;
+  struct cJSON *child;
+  int type;
+  char *valuestring;
+  int valueint;
+  double valuedouble;
+  char *string;
+} cJSON;
+
+#define cJSON_Invalid 0
+#define cJSON_False 1
+#define cJSON_True 2
+#define cJSON_NULL 4
+#define cJSON_Number 8
+#define cJSON_String 16
+#define cJSON_Array 32
+#define cJSON_Object 64
+#define cJSON_ArrayForEach(element, array) \
+  for (element = (array != NULL) ? (array)->child : NULL; element != NULL; element = element->next)
+
+cJSON *cJSON_Parse(const char *value);
+cJSON *cJSON_ParseWithLength(const char *value, size_t length);
+void cJSON_Delete(cJSON *item);
+char *cJSON_Print(const cJSON *item);
+char *cJSON_PrintUnformatted(const cJSON *item);
+int cJSON_PrintPreallocated(cJSON *item, char *buffer, const int length, const int format);
+void cJSON_free(void *object);
+cJSON *cJSON_GetObjectItem(const cJSON *object, const char *string);
+cJSON *cJSON_GetObjectItemCaseSensitive(const cJSON *object, const char *string);
+char *cJSON_GetStringValue(const cJSON *item);
+double cJSON_GetNumberValue(const cJSON *item);
+cJSON *cJSON_CreateObject(void);
+int cJSON_AddItemToObject(cJSON *object, const char *string, cJSON *item);
+cJSON *cJSON_AddNumberToObject(cJSON *object, const char *name, const double number);
+cJSON *cJSON_AddStringToObject(cJSON *object, const char *name, const char *string);
@@ -0,0 +1,55 @@
+#pragma once
+/*
+ * Pins read stub_gpio_level; gpio_isr_handler_add() records the handler in
+ * stub_gpio_isr, so a test can raise the "interrupt" itself
+ */
+#include "esp_err.h"
+
+typedef int gpio_num_t;
+#define GPIO_NUM_NC ((gpio_num_t)-1)
+#define GPIO_NUM_2 ((gpio_num_t)2)
+
+typedef enum
+{
+  GPIO_INTR_DISABLE = 0,
+  GPIO_INTR_POSEDGE = 1,
+  GPIO_INTR_NEGEDGE = 2,
+  GPIO_INTR_ANYEDGE = 3
+} gpio_int_type_t;
+typedef enum
+{
+  GPIO_MODE_INPUT = 1,
+  GPIO_MODE_OUTPUT = 2
+} gpio_mode_t;
+enum
+{
+  GPIO_PULLUP_DISABLE = 0,
+  GPIO_PULLUP_ENABLE = 1,
+  GPIO_PULLDOWN_DISABLE = 0,
+  GPIO_PULLDOWN_ENABLE = 1
+};
+typedef struct
+{
+  unsigned long long pin_bit_mask;
+  gpio_mode_t mode;
+  int pull_up_en;
+  int pull_down_en;
+  gpio_int_type_t intr_type;
+} gpio_config_t;
+typedef void (*gpio_isr_t)(void *arg);
+
+extern int stub_gpio_level;
+extern gpio_isr_t stub_gpio_isr;
+extern void *stub_gpio_isr_arg;
+
+inline esp_err_t gpio_config(const gpio_config_t *config) { return ESP_OK; }
+inline esp_err_t gpio_set_direction(gpio_num_t pin, gpio_mode_t mode) { return ESP_OK; }
+inline esp_err_t gpio_set_level(gpio_num_t pin, uint32_t level) { return ESP_OK; }
+inline int gpio_get_level(gpio_num_t pin) { return stub_gpio_level; }
+inline esp_err_t gpio_install_isr_service(int flags) { return ESP_OK; }
+inline esp_err_t gpio_isr_handler_add(gpio_num_t pin, gpio_isr_t handler, void *arg)
+{
+  stub_gpio_isr = handler;
+  stub_gpio_isr_arg = arg;
+  return ESP_OK;
+}
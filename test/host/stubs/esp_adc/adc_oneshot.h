@@ -0,0 +1,45 @@
+#pragma once
+/*
+ * Every channel reads stub_adc_value
+ */
+#include "esp_err.h"
+
+typedef int adc_channel_t;
+typedef int adc_atten_t;
+typedef int adc_bitwidth_t;
+typedef int adc_unit_t;
+typedef int adc_ulp_mode_t;
+#define ADC_UNIT_1 0
+#define ADC_ULP_MODE_DISABLE 0
+#define ADC_ATTEN_DB_11 3
+#define ADC_BITWIDTH_12 12
+
+typedef struct adc_oneshot_unit *adc_oneshot_unit_handle_t;
+typedef struct
+{
+  adc_unit_t unit_id;
+  adc_ulp_mode_t ulp_mode;
+} adc_oneshot_unit_init_cfg_t;
+typedef struct
+{
+  adc_atten_t atten;
+  adc_bitwidth_t bitwidth;
+} adc_oneshot_chan_cfg_t;
+
+extern int stub_adc_value;
+
+inline esp_err_t adc_oneshot_new_unit(const adc_oneshot_unit_init_cfg_t *config, adc_oneshot_unit_handle_t *unit)
+{
+  *unit = NULL;
+  return ESP_OK;
+}
+inline esp_err_t adc_oneshot_config_channel(adc_oneshot_unit_handle_t unit, adc_channel_t channel,
+                                            const adc_oneshot_chan_cfg_t *config)
+{
+  return ESP_OK;
+}
+inline esp_err_t adc_oneshot_read(adc_oneshot_unit_handle_t unit, adc_channel_t channel, int *value)
+{
+  *value = stub_adc_value;
+  return ESP_OK;
+}
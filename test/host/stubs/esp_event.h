@@ -0,0 +1,14 @@
+#pragma once
+#include "esp_err.h"
+
+typedef const char *esp_event_base_t;
+typedef void (*esp_event_handler_t)(void *arg, esp_event_base_t base, int32_t id, void *data);
+#define ESP_EVENT_ANY_ID -1
+#define BIT0 0x01
+#define BIT1 0x02
+
+inline esp_err_t esp_event_handler_register(esp_event_base_t base, int32_t id, esp_event_handler_t handler, void *arg)
+{
+  return ESP_OK;
+}
+inline esp_err_t esp_event_loop_create_default() { return ESP_OK; }
@@ -0,0 +1,140 @@
+#pragma once
+/*
+ * Stand-in for the esp_http_server subset used by WebsocketHost
+ *
+ * Nothing is networked: clients are entries in stub_clients, frames sent to
+ * a client are recorded there, httpd_queue_work() queues to stub_work for
+ * the test to run, and httpd_ws_recv_frame() returns stub_recv
+ */
+#include <string.h>
+#include <string>
+#include <utility>
+#include <vector>
+#include "esp_err.h"
+
+typedef void *httpd_handle_t;
+typedef enum
+{
+  HTTP_GET = 1,
+  HTTP_POST = 3
+} httpd_method_t;
+
+typedef struct httpd_req
+{
+  httpd_handle_t handle;
+  int method;
+  const char *uri;
+  size_t content_len;
+  void *aux;
+  void *user_ctx;
+  void *sess_ctx;
+  void (*free_ctx)(void *ctx);
+  bool ignore_sess_ctx_changes;
+  int fd; ///< Stub only: the request's socket
+} httpd_req_t;
+
+typedef struct httpd_uri
+{
+  const char *uri;
+  int method;
+  esp_err_t (*handler)(httpd_req_t *r);
+  void *user_ctx;
+  bool is_websocket;
+  bool handle_ws_control_frames;
+  const char *supported_subprotocol;
+} httpd_uri_t;
+
+typedef enum
+{
+  HTTPD_WS_TYPE_CONTINUE = 0x0,
+  HTTPD_WS_TYPE_TEXT = 0x1,
+  HTTPD_WS_TYPE_BINARY = 0x2,
+  HTTPD_WS_TYPE_CLOSE = 0x8,
+  HTTPD_WS_TYPE_PING = 0x9,
+  HTTPD_WS_TYPE_PONG = 0xA
+} httpd_ws_type_t;
+
+typedef struct httpd_ws_frame
+{
+  bool final;
+  bool fragmented;
+  httpd_ws_type_t type;
+  uint8_t *payload;
+  size_t len;
+} httpd_ws_frame_t;
+
+typedef enum
+{
+  HTTPD_WS_CLIENT_INVALID = 0x0,
+  HTTPD_WS_CLIENT_HTTP = 0x1,
+  HTTPD_WS_CLIENT_WEBSOCKET = 0x2
+} httpd_ws_client_info_t;
+
+typedef void (*httpd_work_fn_t)(void *arg);
+typedef void (*httpd_close_func_t)(httpd_handle_t hd, int sockfd);
+typedef void (*transfer_complete_cb)(esp_err_t err, int socket, void *arg);
+
+typedef struct
+{
+  unsigned task_priority;
+  size_t stack_size;
+  int core_id;
+  uint16_t server_port;
+  uint16_t ctrl_port;
+  uint16_t max_open_sockets;
+  uint16_t max_uri_handlers;
+  uint16_t max_resp_headers;
+  uint16_t backlog_conn;
+  bool lru_purge_enable;
+  uint16_t recv_wait_timeout;
+  uint16_t send_wait_timeout;
+  void *global_user_ctx;
+  void (*global_user_ctx_free_fn)(void *ctx);
+  void *global_transport_ctx;
+  void (*global_transport_ctx_free_fn)(void *ctx);
+  bool enable_so_linger;
+  int linger_timeout;
+  bool keep_alive_enable;
+  int keep_alive_idle;
+  int keep_alive_interval;
+  int keep_alive_count;
+  void *open_fn;
+  httpd_close_func_t close_fn;
+  void *uri_match_fn;
+} httpd_config_t;
+#define HTTPD_DEFAULT_CONFIG() { 5, 4096, 0x7fffffff, 80, 32768, 7, 8, 8, 5, false, 5, 5, \
+                                 NULL, NULL, NULL, NULL, false, 0, false, 5, 5, 3, NULL, NULL, NULL }
+
+/// A connected client, and the frames sent to it
+typedef struct
+{
+  int fd;
+  bool websocket;
+  std::vector<std::string> frames;
+  std::vector<int> types;
+  esp_err_t fail; ///< Returned by sends to this client, if not ESP_OK
+} StubWsClient;
+
+extern std::vector<StubWsClient> stub_clients;
+extern std::vector<std::pair<httpd_work_fn_t, void *>> stub_work;
+extern std::string stub_recv;
+extern httpd_ws_type_t stub_recv_type;
+extern bool stub_recv_final;
+
+esp_err_t httpd_start(httpd_handle_t *handle, const httpd_config_t *config);
+esp_err_t httpd_stop(httpd_handle_t handle);
+esp_err_t httpd_register_uri_handler(httpd_handle_t handle, const httpd_uri_t *uri_handler);
+esp_err_t httpd_queue_work(httpd_handle_t handle, httpd_work_fn_t work, void *arg);
+esp_err_t httpd_get_client_list(httpd_handle_t handle, size_t *fds, int *client_fds);
+httpd_ws_client_info_t httpd_ws_get_fd_info(httpd_handle_t hd, int fd);
+esp_err_t httpd_ws_send_frame_async(httpd_handle_t hd, int fd, httpd_ws_frame_t *frame);
+esp_err_t httpd_ws_send_data_async(httpd_handle_t handle, int socket, httpd_ws_frame_t *frame,
+                                   transfer_complete_cb callback, void *arg);
+esp_err_t httpd_ws_recv_frame(httpd_req_t *req, httpd_ws_frame_t *pkt, size_t max_len);
+int httpd_req_to_sockfd(httpd_req_t *r);
+esp_err_t httpd_sess_trigger_close(httpd_handle_t handle, int sockfd);
+void *httpd_get_global_user_ctx(httpd_handle_t handle);
+
+/// Run, and clear, the queued httpd work
+/// @return number of work items run
+size_t stub_run_work();
@@ -0,0 +1,27 @@
+#pragma once
+#include "esp_event.h"
+
+typedef struct
+{
+  uint32_t addr;
+} esp_ip4_addr_t;
+typedef struct
+{
+  esp_ip4_addr_t ip;
+} esp_netif_ip_info_t;
+typedef struct
+{
+  esp_netif_ip_info_t ip_info;
+} ip_event_got_ip_t;
+
+extern esp_event_base_t IP_EVENT;
+enum
+{
+  IP_EVENT_STA_GOT_IP
+};
+#define IPSTR "%d.%d.%d.%d"
+#define IP2STR(a) (int)((a)->addr & 0xff), (int)(((a)->addr >> 8) & 0xff), \
+                  (int)(((a)->addr >> 16) & 0xff), (int)(((a)->addr >> 24) & 0xff)
+
+inline esp_err_t esp_netif_init() { return ESP_OK; }
+inline void *esp_netif_create_default_wifi_sta() { return NULL; }
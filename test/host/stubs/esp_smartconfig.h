@@ -0,0 +1,41 @@
+#pragma once
+#include "esp_event.h"
+
+typedef enum
+{
+  SC_TYPE_ESPTOUCH = 0,
+  SC_TYPE_ESPTOUCH_V2 = 3
+} smartconfig_type_t;
+
+extern esp_event_base_t SC_EVENT;
+enum
+{
+  SC_EVENT_SCAN_DONE,
+  SC_EVENT_FOUND_CHANNEL,
+  SC_EVENT_GOT_SSID_PSWD,
+  SC_EVENT_SEND_ACK_DONE
+};
+
+typedef struct
+{
+  uint8_t ssid[32];
+  uint8_t password[64];
+  bool bssid_set;
+  uint8_t bssid[6];
+  smartconfig_type_t type;
+  uint8_t token;
+  uint8_t cellphone_ip[4];
+} smartconfig_event_got_ssid_pswd_t;
+
+typedef struct
+{
+  bool enable_log;
+  bool esp_touch_v2_enable_crypt;
+  char *esp_touch_v2_key;
+} smartconfig_start_config_t;
+#define SMARTCONFIG_START_CONFIG_DEFAULT() { false, false, NULL }
+
+inline esp_err_t esp_smartconfig_set_type(smartconfig_type_t type) { return ESP_OK; }
+inline esp_err_t esp_smartconfig_start(const smartconfig_start_config_t *config) { return ESP_OK; }
+inline esp_err_t esp_smartconfig_stop() { return ESP_OK; }
+inline esp_err_t esp_smartconfig_get_rvd_data(uint8_t *data, uint8_t length) { return ESP_OK; }
@@ -0,0 +1,4 @@
+#pragma once
+#include <stdint.h>
+
+inline uint32_t esp_get_free_heap_size() { return 100000; }
@@ -0,0 +1,62 @@
+#pragma once
+#include <stdint.h>
+#include <chrono>
+#include "esp_err.h"
+
+inline int64_t esp_timer_get_time()
+{
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+typedef void (*esp_timer_cb_t)(void *arg);
+typedef enum
+{
+  ESP_TIMER_TASK
+} esp_timer_dispatch_t;
+typedef struct
+{
+  esp_timer_cb_t callback;
+  void *arg;
+  esp_timer_dispatch_t dispatch_method;
+  const char *name;
+  bool skip_unhandled_events;
+} esp_timer_create_args_t;
+
+/// One shot timer; never fires by itself, see stub_timer_fire()
+typedef struct
+{
+  esp_timer_cb_t callback;
+  void *arg;
+  bool active;
+  uint64_t timeoutUs;
+} StubTimer;
+typedef StubTimer *esp_timer_handle_t;
+
+inline esp_err_t esp_timer_create(const esp_timer_create_args_t *args, esp_timer_handle_t *timer)
+{
+  *timer = new StubTimer{args->callback, args->arg, false, 0};
+  return ESP_OK;
+}
+inline esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeoutUs)
+{
+  timer->active = true;
+  timer->timeoutUs = timeoutUs;
+  return ESP_OK;
+}
+inline esp_err_t esp_timer_stop(esp_timer_handle_t timer)
+{
+  timer->active = false;
+  return ESP_OK;
+}
+inline bool esp_timer_is_active(esp_timer_handle_t timer) { return timer->active; }
+
+/// Run an active timer's callback now
+inline void stub_timer_fire(esp_timer_handle_t timer)
+{
+  if (timer->active)
+  {
+    timer->active = false;
+    timer->callback(timer->arg);
+  }
+}
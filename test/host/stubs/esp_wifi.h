@@ -0,0 +1,58 @@
+#pragma once
+#include <string.h>
+#include "esp_event.h"
+
+typedef enum
+{
+  WIFI_MODE_STA = 1
+} wifi_mode_t;
+typedef enum
+{
+  WIFI_IF_STA = 0
+} wifi_interface_t;
+#define ESP_IF_WIFI_STA WIFI_IF_STA
+
+typedef struct
+{
+  uint8_t ssid[32];
+  uint8_t password[64];
+  bool bssid_set;
+  uint8_t bssid[6];
+} wifi_sta_config_t;
+typedef union
+{
+  wifi_sta_config_t sta;
+} wifi_config_t;
+typedef struct
+{
+  int unused;
+} wifi_init_config_t;
+#define WIFI_INIT_CONFIG_DEFAULT() { 0 }
+typedef struct
+{
+  uint8_t ssid[33];
+  int8_t rssi;
+  uint8_t primary;
+} wifi_ap_record_t;
+
+extern esp_event_base_t WIFI_EVENT;
+enum
+{
+  WIFI_EVENT_STA_START = 2,
+  WIFI_EVENT_STA_DISCONNECTED = 5
+};
+
+inline esp_err_t esp_wifi_init(const wifi_init_config_t *config) { return ESP_OK; }
+inline esp_err_t esp_wifi_set_config(wifi_interface_t iface, wifi_config_t *config) { return ESP_OK; }
+inline esp_err_t esp_wifi_get_config(wifi_interface_t iface, wifi_config_t *config) { return ESP_OK; }
+inline esp_err_t esp_wifi_set_mode(wifi_mode_t mode) { return ESP_OK; }
+inline esp_err_t esp_wifi_start() { return ESP_OK; }
+inline esp_err_t esp_wifi_connect() { return ESP_OK; }
+inline esp_err_t esp_wifi_disconnect() { return ESP_OK; }
+inline esp_err_t esp_wifi_scan_start(const void *config, bool block) { return ESP_OK; }
+inline esp_err_t esp_wifi_scan_get_ap_num(uint16_t *number)
+{
+  *number = 0;
+  return ESP_OK;
+}
+inline esp_err_t esp_wifi_scan_get_ap_records(uint16_t *number, wifi_ap_record_t *records) { return ESP_OK; }
@@ -0,0 +1,204 @@
+#pragma once
+/*
+ * Host (Linux) stand-in for the FreeRTOS subset used by ObjMsg
+ *
+ * Tasks are detached std::threads, a tick is one millisecond, and queues and
+ * semaphores are fixed size rings, allocated at creation as FreeRTOS does,
+ * guarded by a mutex and condition variable. Task priorities, core affinity
+ * and stack sizes are ignored. This is not the FreeRTOS POSIX port; it is
+ * enough to run ObjMsg's tasks, workers and waits on a desktop.
+ */
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include "sdkconfig.h"
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned UBaseType_t;
+
+#define pdTRUE 1
+#define pdFALSE 0
+#define pdPASS 1
+#define portMAX_DELAY 0xffffffffu
+#define portTICK_PERIOD_MS 1
+#define configTICK_RATE_HZ 1000
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+#define tskIDLE_PRIORITY 0
+#define tskNO_AFFINITY 0x7fffffff
+#define portNUM_PROCESSORS 2
+#define IRAM_ATTR
+#define portYIELD_FROM_ISR(woken) (void)(woken)
+
+/// Critical section lock; recursive, as portMUX is on one core
+typedef struct
+{
+  std::recursive_mutex m;
+} portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED {}
+#define portENTER_CRITICAL(mux) (mux)->m.lock()
+#define portEXIT_CRITICAL(mux) (mux)->m.unlock()
+#define portENTER_CRITICAL_ISR(mux) (mux)->m.lock()
+#define portEXIT_CRITICAL_ISR(mux) (mux)->m.unlock()
+
+/// Queue of 'length' items of 'size' bytes (0 for semaphores)
+struct QueueDefinition
+{
+  std::mutex m;
+  std::condition_variable cv;
+  uint8_t *storage;
+  size_t length;
+  size_t size;
+  size_t head;
+  size_t count;
+};
+typedef QueueDefinition *QueueHandle_t;
+typedef QueueDefinition *SemaphoreHandle_t;
+
+/// Wait up to 'ticks' for 'ready'
+template <class F>
+inline bool StubWait(QueueHandle_t q, std::unique_lock<std::mutex> &lock, TickType_t ticks, F ready)
+{
+  if (ticks == 0)
+  {
+    // wait_for() would sleep for the timer slack, even with no timeout
+    return ready();
+  }
+  if (ticks == portMAX_DELAY)
+  {
+    q->cv.wait(lock, ready);
+    return true;
+  }
+  return q->cv.wait_for(lock, std::chrono::milliseconds(ticks), ready);
+}
+
+inline QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t size)
+{
+  QueueHandle_t q = new QueueDefinition;
+  q->storage = size ? new uint8_t[length * size] : NULL;
+  q->length = length;
+  q->size = size;
+  q->head = 0;
+  q->count = 0;
+  return q;
+}
+
+inline void vQueueDelete(QueueHandle_t q)
+{
+  delete[] q->storage;
+  delete q;
+}
+
+inline BaseType_t xQueueSend(QueueHandle_t q, const void *item, TickType_t ticks)
+{
+  std::unique_lock<std::mutex> lock(q->m);
+  if (!StubWait(q, lock, ticks, [q] { return q->count < q->length; }))
+  {
+    return pdFALSE;
+  }
+  if (q->size)
+  {
+    memcpy(q->storage + ((q->head + q->count) % q->length) * q->size, item, q->size);
+  }
+  ++q->count;
+  q->cv.notify_all();
+  return pdTRUE;
+}
+#define xQueueSendToBack xQueueSend
+
+inline BaseType_t xQueueReceive(QueueHandle_t q, void *item, TickType_t ticks)
+{
+  std::unique_lock<std::mutex> lock(q->m);
+  if (!StubWait(q, lock, ticks, [q] { return q->count > 0; }))
+  {
+    return pdFALSE;
+  }
+  if (q->size)
+  {
+    memcpy(item, q->storage + q->head * q->size, q->size);
+  }
+  q->head = (q->head + 1) % q->length;
+  --q->count;
+  q->cv.notify_all();
+  return pdTRUE;
+}
+
+inline BaseType_t xQueueSendFromISR(QueueHandle_t q, const void *item, BaseType_t *woken)
+{
+  return xQueueSend(q, item, 0);
+}
+
+inline BaseType_t xQueueReceiveFromISR(QueueHandle_t q, void *item, BaseType_t *woken)
+{
+  return xQueueReceive(q, item, 0);
+}
+
+inline UBaseType_t uxQueueMessagesWaiting(QueueHandle_t q)
+{
+  std::lock_guard<std::mutex> lock(q->m);
+  return q->count;
+}
+
+inline UBaseType_t uxQueueSpacesAvailable(QueueHandle_t q)
+{
+  std::lock_guard<std::mutex> lock(q->m);
+  return q->length - q->count;
+}
+
+inline SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t max, UBaseType_t initial)
+{
+  SemaphoreHandle_t s = xQueueCreate(max, 0);
+  s->count = initial;
+  return s;
+}
+
+inline SemaphoreHandle_t xSemaphoreCreateBinary() { return xSemaphoreCreateCounting(1, 0); }
+inline SemaphoreHandle_t xSemaphoreCreateMutex() { return xSemaphoreCreateCounting(1, 1); }
+inline BaseType_t xSemaphoreTake(SemaphoreHandle_t s, TickType_t ticks) { return xQueueReceive(s, NULL, ticks); }
+inline BaseType_t xSemaphoreGive(SemaphoreHandle_t s) { return xQueueSend(s, NULL, 0); }
+inline BaseType_t xSemaphoreGiveFromISR(SemaphoreHandle_t s, BaseType_t *woken) { return xSemaphoreGive(s); }
+inline void vSemaphoreDelete(SemaphoreHandle_t s) { vQueueDelete(s); }
+
+typedef void *TaskHandle_t;
+typedef void (*TaskFunction_t)(void *);
+
+inline BaseType_t xTaskCreate(TaskFunction_t task, const char *name, uint32_t stackSize,
+                              void *arg, UBaseType_t priority, TaskHandle_t *handle)
+{
+  std::thread(task, arg).detach();
+  if (handle)
+  {
+    *handle = (TaskHandle_t)task;
+  }
+  return pdPASS;
+}
+
+inline BaseType_t xTaskCreatePinnedToCore(TaskFunction_t task, const char *name, uint32_t stackSize,
+                                          void *arg, UBaseType_t priority, TaskHandle_t *handle, BaseType_t core)
+{
+  return xTaskCreate(task, name, stackSize, arg, priority, handle);
+}
+
+/// Only a task deleting itself is supported; it stops here
+inline void vTaskDelete(TaskHandle_t task)
+{
+  if (!task)
+  {
+    for (;;)
+    {
+      std::this_thread::sleep_for(std::chrono::hours(1));
+    }
+  }
+}
+
+inline TickType_t xTaskGetTickCount()
+{
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+inline void vTaskDelay(TickType_t ticks) { std::this_thread::sleep_for(std::chrono::milliseconds(ticks)); }
@@ -0,0 +1,24 @@
+#pragma once
+#include "FreeRTOS.h"
+
+typedef uint32_t EventBits_t;
+typedef struct
+{
+  EventBits_t bits;
+} StubEventGroup;
+typedef StubEventGroup *EventGroupHandle_t;
+
+inline EventGroupHandle_t xEventGroupCreate() { return new StubEventGroup{0}; }
+inline EventBits_t xEventGroupSetBits(EventGroupHandle_t group, EventBits_t bits) { return group->bits |= bits; }
+inline EventBits_t xEventGroupClearBits(EventGroupHandle_t group, EventBits_t bits)
+{
+  EventBits_t was = group->bits;
+  group->bits &= ~bits;
+  return was;
+}
+/// Does not wait; returns the bits as they are
+inline EventBits_t xEventGroupWaitBits(EventGroupHandle_t group, EventBits_t bits, BaseType_t clear,
+                                       BaseType_t all, TickType_t ticks)
+{
+  return group->bits;
+}
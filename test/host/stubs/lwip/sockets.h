@@ -0,0 +1,29 @@
+#pragma once
+/*
+ * select() reports every socket writable, except those in stub_unwritable
+ */
+#include <sys/select.h>
+#include <set>
+
+extern std::set<int> stub_unwritable;
+
+inline int stub_select(int count, fd_set *readable, fd_set *writable, fd_set *failed, struct timeval *timeout)
+{
+  int ready = 0;
+  for (int fd = 0; writable && fd < FD_SETSIZE; fd++)
+  {
+    if (FD_ISSET(fd, writable))
+    {
+      if (stub_unwritable.count(fd))
+      {
+        FD_CLR(fd, writable);
+      }
+      else
+      {
+        ready++;
+      }
+    }
+  }
+  return ready;
+}
+#define select stub_select
@@ -0,0 +1,6 @@
+#pragma once
+/*
+ * Host build configuration, in place of the generated sdkconfig.h
+ */
+#define CONFIG_ESP_MINIMAL_SHARED_STACK_SIZE 2048
+#define CONFIG_LWIP_MAX_LISTENING_TCP 16
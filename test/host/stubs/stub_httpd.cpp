@@ -0,0 +1,129 @@
+#include "esp_http_server.h"
+#include <algorithm>
+
+std::vector<StubWsClient> stub_clients;
+std::vector<std::pair<httpd_work_fn_t, void *>> stub_work;
+std::string stub_recv;
+httpd_ws_type_t stub_recv_type = HTTPD_WS_TYPE_TEXT;
+bool stub_recv_final = true;
+
+static int server;
+
+static StubWsClient *Find(int fd)
+{
+  for (StubWsClient &client : stub_clients)
+  {
+    if (client.fd == fd)
+    {
+      return &client;
+    }
+  }
+  return NULL;
+}
+
+esp_err_t httpd_start(httpd_handle_t *handle, const httpd_config_t *config)
+{
+  *handle = &server;
+  return ESP_OK;
+}
+
+esp_err_t httpd_stop(httpd_handle_t handle) { return ESP_OK; }
+
+esp_err_t httpd_register_uri_handler(httpd_handle_t handle, const httpd_uri_t *uri_handler) { return ESP_OK; }
+
+esp_err_t httpd_queue_work(httpd_handle_t handle, httpd_work_fn_t work, void *arg)
+{
+  stub_work.push_back({work, arg});
+  return ESP_OK;
+}
+
+esp_err_t httpd_get_client_list(httpd_handle_t handle, size_t *fds, int *client_fds)
+{
+  size_t count = 0;
+  for (StubWsClient &client : stub_clients)
+  {
+    if (count < *fds)
+    {
+      client_fds[count++] = client.fd;
+    }
+  }
+  *fds = count;
+  return ESP_OK;
+}
+
+httpd_ws_client_info_t httpd_ws_get_fd_info(httpd_handle_t hd, int fd)
+{
+  StubWsClient *client = Find(fd);
+  if (!client)
+  {
+    return HTTPD_WS_CLIENT_INVALID;
+  }
+  return client->websocket ? HTTPD_WS_CLIENT_WEBSOCKET : HTTPD_WS_CLIENT_HTTP;
+}
+
+esp_err_t httpd_ws_send_frame_async(httpd_handle_t hd, int fd, httpd_ws_frame_t *frame)
+{
+  StubWsClient *client = Find(fd);
+  if (!client)
+  {
+    return ESP_FAIL;
+  }
+  if (client->fail != ESP_OK)
+  {
+    return client->fail;
+  }
+  client->frames.emplace_back((const char *)frame->payload, frame->len);
+  client->types.push_back(frame->type);
+  return ESP_OK;
+}
+
+esp_err_t httpd_ws_send_data_async(httpd_handle_t handle, int socket, httpd_ws_frame_t *frame,
+                                   transfer_complete_cb callback, void *arg)
+{
+  esp_err_t err = httpd_ws_send_frame_async(handle, socket, frame);
+  if (err == ESP_OK && callback)
+  {
+    callback(ESP_OK, socket, arg);
+  }
+  return err;
+}
+
+esp_err_t httpd_ws_recv_frame(httpd_req_t *req, httpd_ws_frame_t *pkt, size_t max_len)
+{
+  pkt->type = stub_recv_type;
+  pkt->final = stub_recv_final;
+  pkt->len = stub_recv.size();
+  if (!max_len)
+  {
+    return ESP_OK;
+  }
+  if (stub_recv.size() > max_len)
+  {
+    return ESP_ERR_INVALID_SIZE;
+  }
+  memcpy(pkt->payload, stub_recv.data(), stub_recv.size());
+  return ESP_OK;
+}
+
+int httpd_req_to_sockfd(httpd_req_t *r) { return r->fd; }
+
+esp_err_t httpd_sess_trigger_close(httpd_handle_t handle, int sockfd)
+{
+  stub_clients.erase(std::remove_if(stub_clients.begin(), stub_clients.end(),
+                                    [sockfd](const StubWsClient &client) { return client.fd == sockfd; }),
+                     stub_clients.end());
+  return ESP_OK;
+}
+
+void *httpd_get_global_user_ctx(httpd_handle_t handle) { return NULL; }
+
+size_t stub_run_work()
+{
+  std::vector<std::pair<httpd_work_fn_t, void *>> work;
+  work.swap(stub_work);
+  for (std::pair<httpd_work_fn_t, void *> &item : work)
+  {
+    item.first(item.second);
+  }
+  return work.size();
+}
@@ -0,0 +1,15 @@
+#include "esp_wifi.h"
+#include "esp_netif.h"
+#include "esp_smartconfig.h"
+#include "driver/gpio.h"
+#include "esp_adc/adc_oneshot.h"
+#include "lwip/sockets.h"
+
+esp_event_base_t WIFI_EVENT = "WIFI_EVENT";
+esp_event_base_t IP_EVENT = "IP_EVENT";
+esp_event_base_t SC_EVENT = "SC_EVENT";
+std::set<int> stub_unwritable;
+int stub_gpio_level;
+gpio_isr_t stub_gpio_isr;
+void *stub_gpio_isr_arg;
+int stub_adc_value;
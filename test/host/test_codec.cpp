@@ -0,0 +1,280 @@
+/*
+ * Encodings: the streaming JSON writer and Serialize(), the one pass JSON
+ * reader and Deserialize(), the binary (MessagePack) reader and writer, with
+ * round trips of each data class through SerializeBinary() and
+ * DeserializeBinary(), and the encodings Encode() shares between consumers
+ */
+#include "ObjMsg.h"
+#include "ObjMsgJoystickData.h"
+#include "check.h"
+#include <thread>
+
+#define ORIGIN 1
+
+/// Encode 'data' and decode it again, checking the value survives
+static ObjMsgDataRef RoundTrip(ObjMsgDataRef data, vector<uint8_t> &binary)
+{
+  binary.clear();
+  CHECK(data->SerializeBinary(binary) == 0);
+  ObjMsgDataRef decoded = ObjMsgData::DeserializeBinary(ORIGIN, binary.data(), binary.size());
+  CHECK(decoded && decoded->IsFrom(ORIGIN) && decoded->IsNamed(data->GetNameId()));
+  string expected, value;
+  CHECK(data->GetValue(expected) == decoded->GetValue(value) && value == expected);
+  return decoded;
+}
+
+/// JSON is written compact and escaped, and stops at the end of the buffer
+static void TestJsonWriter()
+{
+  char buffer[64];
+  ObjMsgJsonWriter writer(buffer, sizeof(buffer));
+  writer.Char('[');
+  writer.Int(INT64_MIN);
+  writer.Char(',');
+  writer.Double(0.1);
+  writer.Char(',');
+  writer.Double(1.0 / 0.0);
+  writer.Char(',');
+  writer.String("a\"\\\n\x01");
+  writer.Char(']');
+  CHECK(!writer.Overflow());
+  CHECK(string(writer.c_str()) == "[-9223372036854775808,0.1,null,\"a\\\"\\\\\\n\\u0001\"]");
+  CHECK(writer.Length() == strlen(buffer));
+
+  // Output that does not fit is dropped whole, leaving a terminated prefix
+  ObjMsgJsonWriter small(buffer, 8);
+  small.Raw("12345");
+  small.Raw("678");
+  CHECK(small.Overflow() && string(buffer) == "12345");
+  small.Raw("6");
+  CHECK(string(buffer) == "12345");
+
+  // Serialize(string&) grows the string to fit
+  string json;
+  CHECK(ObjMsgDataInt::Create(ORIGIN, "zoom", -3)->Serialize(json) == 0);
+  CHECK(json == "{\"name\":\"zoom\",\"value\":-3}");
+  string longValue(1000, 'x');
+  CHECK(ObjMsgDataString::Create(ORIGIN, "scene", longValue.c_str())->Serialize(json) == 0);
+  CHECK(json == "{\"name\":\"scene\",\"value\":\"" + longValue + "\"}");
+  CHECK(ObjMsgDataString::Create(ORIGIN, "scene", "{\"a\":1}", true)->Serialize(json) == 0);
+  CHECK(json == "{\"name\":\"scene\",\"value\":{\"a\":1}}");
+  joystick_sample_t sample = {-1, 2, 0};
+  ObjMsgDataRef joystick = ObjMsgJoystickData::Create(ORIGIN, "pantilt", sample);
+  ObjMsgJsonWriter exact(buffer, joystick->Serialize(json) == 0 ? json.size() + 1 : 0);
+  CHECK(joystick->Serialize(exact) && exact.c_str() == json);
+}
+
+/// ObjMsgJsonReader splits members in one pass and reads scalars in place
+static void TestJsonReader()
+{
+  ObjMsgJsonReader reader(" { \"a\" : [1, {\"b\": \"}\"}] ,\"c\":\"x\\\"y\", \"d\":-2.5e1 } ");
+  string_view key, value;
+  CHECK(reader.Next(key, value) && key == "a" && value == "[1, {\"b\": \"}\"}]");
+  CHECK(reader.Next(key, value) && key == "c" && value == "\"x\\\"y\"");
+  CHECK(reader.Next(key, value) && key == "d" && value == "-2.5e1");
+  CHECK(!reader.Next(key, value) && reader.Done());
+
+  // Arrays are read by element, and only by element
+  ObjMsgJsonReader array(" [1, \"]\" ,{\"b\":[2]}] ");
+  CHECK(!array.Next(key, value));
+  CHECK(array.Next(value) && value == "1" && array.Next(value) && value == "\"]\"");
+  CHECK(array.Next(value) && value == "{\"b\":[2]}" && !array.Next(value) && array.Done());
+  ObjMsgJsonReader empty("[]");
+  CHECK(!empty.Next(value) && empty.Done());
+  const char *truncated[] = {"[", "[1,", "[1 2]", "[1]]"};
+  for (const char *json : truncated)
+  {
+    ObjMsgJsonReader bad(json);
+    while (bad.Next(value))
+    {
+    }
+    CHECK(!bad.Done());
+  }
+
+  const char *malformed[] = {"", "[]", "{", "{\"a\"}", "{\"a\":}", "{\"a\":1 \"b\":2}", "{\"a\":\"x}", "{} x",
+                             "{\"a\":1,"};
+  for (const char *json : malformed)
+  {
+    ObjMsgJsonReader bad(json);
+    while (bad.Next(key, value))
+    {
+    }
+    CHECK(!bad.Done());
+  }
+
+  int64_t i;
+  double d;
+  string str;
+  CHECK(ObjMsgJsonReader::Int("-42", i) && i == -42);
+  CHECK(ObjMsgJsonReader::Int("7.9", i) && i == 7);
+  CHECK(!ObjMsgJsonReader::Int("\"7\"", i) && !ObjMsgJsonReader::Int("1e300", i));
+  CHECK(ObjMsgJsonReader::Double("1.5e3", d) && d == 1500 && !ObjMsgJsonReader::Double("1.5x", d));
+  CHECK(ObjMsgJsonReader::String("\"a\\tb\\u00e9\\ud83d\\ude00\\/\"", str));
+  CHECK(str == "a\tb\xc3\xa9\xf0\x9f\x98\x80/");
+  CHECK(!ObjMsgJsonReader::String("\"a\\u00\"", str) && !ObjMsgJsonReader::String("a", str));
+  CHECK(ObjMsgJsonReader::Member("{\"x\":1,\"up\":true}", "up", value) && value == "true");
+}
+
+/// Deserialize() finds name and value in any order, and creates the
+/// registered class; anything else gives NULL
+static void TestDeserialize()
+{
+  ObjMsgData::RegisterClass(ORIGIN, "pantilt", ObjMsgJoystickData::Create);
+  ObjMsgData::RegisterClass(ORIGIN, "zoom", ObjMsgDataInt::Create);
+  ObjMsgData::RegisterClass(ORIGIN, "gain", ObjMsgDataFloat::Create);
+  ObjMsgData::RegisterClass(ORIGIN, "scene", ObjMsgDataString::Create);
+
+  int i;
+  double d;
+  string str;
+  ObjMsgDataRef data = ObjMsgData::Deserialize(2, "{\"value\":12,\"name\":\"zoom\"}");
+  CHECK(data && data->Is<ObjMsgDataInt>() && data->IsFrom(2) && data->GetValue(i) && i == 12);
+  data = ObjMsgData::Deserialize(2, "{\"name\":\"gain\",\"value\":-0.25}");
+  CHECK(data && data->GetValue(d) && d == -0.25);
+  data = ObjMsgData::Deserialize(2, "{\"name\":\"sc\\u0065ne\",\"value\":\"a\\\"b\"}");
+  CHECK(data && data->Is<ObjMsgDataString>() && data->GetValue(str) && str == "a\"b");
+  data = ObjMsgData::Deserialize(2, "{\"name\":\"pantilt\",\"value\":{\"up\":1,\"y\":-5,\"x\":300}}");
+  joystick_sample_t sample;
+  CHECK(data && data->As<ObjMsgJoystickData>()->GetRawValue(sample));
+  CHECK(sample.x == 300 && sample.y == -5 && sample.up == 1);
+
+  const char *rejected[] = {
+    "{\"name\":\"zoom\",\"value\":\"12\"}",               // wrong value type
+    "{\"name\":\"zoom\"}",                                // no value
+    "{\"value\":12}",                                     // no name
+    "{\"name\":\"zoom\",\"value\":12",                    // truncated
+    "{\"name\":\"pantilt\",\"value\":{\"x\":1,\"y\":2}}", // missing field
+    "{\"name\":\"pantilt\",\"value\":{\"x\":1,\"y\":\"2\",\"up\":0}}",
+    "{\"name\":\"never seen\",\"value\":1}",              // not interned
+  };
+  for (const char *json : rejected)
+  {
+    CHECK(!ObjMsgData::Deserialize(2, json));
+  }
+  CHECK(ObjMsgData::FindName("never seen") == OBJMSG_NO_NAME);
+
+  // An interned but unregistered name carries its value's JSON as a string
+  ObjMsgData::InternName("status");
+  data = ObjMsgData::Deserialize(2, "{\"name\":\"status\",\"value\":{\"a\":[1,2]}}");
+  CHECK(data && data->Is<ObjMsgDataString>() && data->GetValue(str) && str == "{\"a\":[1,2]}");
+}
+
+/// Encode() serializes once per value, and consumers share the buffer
+static void TestEncode()
+{
+  ObjMsgDataRef data = ObjMsgDataInt::Create(ORIGIN, "zoom", 5);
+  ObjMsgBufferRef json = data->Encode(JSON_FORMAT);
+  CHECK(json && json == data->Encode(JSON_FORMAT));
+  CHECK(string(json->c_str()) == "{\"name\":\"zoom\",\"value\":5}" && json->Size() == strlen(json->c_str()));
+  ObjMsgBufferRef binary = data->Encode(BINARY_FORMAT);
+  vector<uint8_t> expected;
+  data->SerializeBinary(expected);
+  CHECK(binary && binary != json && binary->Size() == expected.size());
+  CHECK(memcmp(binary->Data(), expected.data(), expected.size()) == 0);
+
+  // A changed value is encoded again; earlier holders keep the old buffer
+  CHECK(data->As<ObjMsgDataInt>()->SetRawValue(6));
+  ObjMsgBufferRef changed = data->Encode(JSON_FORMAT);
+  CHECK(changed != json && string(changed->c_str()) == "{\"name\":\"zoom\",\"value\":6}");
+  CHECK(string(json->c_str()) == "{\"name\":\"zoom\",\"value\":5}" && json.use_count() == 1);
+  data->Changed();
+  CHECK(data->Encode(BINARY_FORMAT) != binary);
+
+  // Larger than the first attempt's buffer
+  string longValue(3 * OBJMSG_ENCODE_SIZE, 'x');
+  ObjMsgDataRef scene = ObjMsgDataString::Create(ORIGIN, "scene", longValue.c_str());
+  string serialized;
+  scene->Serialize(serialized);
+  CHECK(scene->Encode(JSON_FORMAT)->c_str() == serialized);
+
+  // Consumers encoding at once all get the one cached buffer
+  ObjMsgBufferRef results[4];
+  vector<std::thread> threads;
+  for (ObjMsgBufferRef &result : results)
+  {
+    threads.emplace_back([&] { result = data->Encode(JSON_FORMAT); });
+  }
+  for (std::thread &thread : threads)
+  {
+    thread.join();
+  }
+  for (ObjMsgBufferRef &result : results)
+  {
+    CHECK(result == results[0] && result == data->Encode(JSON_FORMAT));
+  }
+}
+
+/// Integers take the fewest bytes, and reads check type and length
+static void TestReaderWriter()
+{
+  vector<uint8_t> out;
+  ObjMsgBinWriter writer(out);
+  writer.Array(3);
+  writer.Int(5);
+  writer.Int(-200);
+  writer.Str("ab");
+  CHECK(out.size() == 1 + 1 + 3 + 3);
+
+  ObjMsgBinReader reader(out.data(), out.size());
+  uint32_t count;
+  int64_t value;
+  string_view str;
+  double d;
+  CHECK(reader.Array(count) && count == 3);
+  CHECK(!reader.Str(str));
+  CHECK(reader.Int(value) && value == 5);
+  CHECK(reader.Double(d) && d == -200);
+  CHECK(reader.Str(str) && str == "ab" && reader.Remaining() == 0);
+  CHECK(!reader.Int(value));
+
+  // A string longer than the buffer is not read
+  ObjMsgBinReader truncated(out.data() + 5, 2);
+  CHECK(!truncated.Str(str) && truncated.Remaining() == 2);
+}
+
+/// Each data class round trips; unregistered names and bad input give NULL
+static void TestRoundTrip()
+{
+  ObjMsgData::RegisterClass(ORIGIN, "pantilt", ObjMsgJoystickData::Create);
+  ObjMsgData::RegisterClass(ORIGIN, "zoom", ObjMsgDataInt::Create);
+  ObjMsgData::RegisterClass(ORIGIN, "gain", ObjMsgDataFloat::Create);
+  ObjMsgData::RegisterClass(ORIGIN, "scene", ObjMsgDataString::Create);
+
+  vector<uint8_t> binary;
+  joystick_sample_t sample = {-120, 345, 1};
+  ObjMsgDataRef joystick = RoundTrip(ObjMsgJoystickData::Create(2, "pantilt", sample), binary);
+  joystick_sample_t decoded;
+  CHECK(joystick->As<ObjMsgJoystickData>()->GetRawValue(decoded));
+  CHECK(decoded.x == sample.x && decoded.y == sample.y && decoded.up == sample.up);
+  CHECK(binary.size() == 1 + 8 + 2 + sizeof(joystick_sample_t));
+
+  RoundTrip(ObjMsgDataInt::Create(2, "zoom", -70000), binary);
+  RoundTrip(ObjMsgDataFloat::Create(2, "gain", 0.75), binary);
+  RoundTrip(ObjMsgDataString::Create(2, "scene", "Camera 2 wide"), binary);
+
+  // Every truncation of a valid encoding is rejected
+  for (size_t size = 0; size < binary.size(); size++)
+  {
+    CHECK(!ObjMsgData::DeserializeBinary(ORIGIN, binary.data(), size));
+  }
+
+  // The value must have the registered class's type
+  binary.clear();
+  ObjMsgDataString::Create(2, "zoom", "7")->SerializeBinary(binary);
+  CHECK(!ObjMsgData::DeserializeBinary(ORIGIN, binary.data(), binary.size()));
+
+  binary.clear();
+  ObjMsgDataInt::Create(2, "unregistered", 1)->SerializeBinary(binary);
+  CHECK(!ObjMsgData::DeserializeBinary(ORIGIN, binary.data(), binary.size()));
+}
+
+int main()
+{
+  TestJsonWriter();
+  TestJsonReader();
+  TestDeserialize();
+  TestEncode();
+  TestReaderWriter();
+  TestRoundTrip();
+  return 0;
+}
@@ -0,0 +1,196 @@
+/*
+ * ObjMsgData: interned names, creating data by name ID, the factory, type
+ * descriptors, checked casts, block pools and counted references
+ */
+#include "ObjMsg.h"
+#include "check.h"
+
+/// Names and name IDs; fills the name table last, as it is never emptied
+static void TestNames()
+{
+  uint16_t level = ObjMsgData::InternName("level");
+  CHECK(level != OBJMSG_NO_NAME && ObjMsgData::InternName("level") == level);
+  CHECK(ObjMsgData::nameRegistry.Name(level) == "level");
+  CHECK(ObjMsgData::FindName("level") == level);
+
+  // Data created by name and by ID share the interned name
+  ObjMsgDataRef byName = ObjMsgDataInt::Create(1, "level", 3);
+  ObjMsgDataRef byId = ObjMsgDataInt::Create(1, level, 4);
+  CHECK(byName->IsNamed(level) && byId->IsNamed(level) && byId->GetName() == "level");
+  int value;
+  CHECK(byId->GetValue(value) && value == 4);
+
+  // Creating an unregistered name neither creates data nor interns it
+  CHECK(ObjMsgData::RegisterClass(1, "level", ObjMsgDataInt::Create));
+  CHECK(!ObjMsgData::RegisterClass(1, "level", ObjMsgDataInt::Create));
+  ObjMsgDataRef created = ObjMsgData::dataFactory.Create(2, "level");
+  CHECK(created && created->IsFrom(2) && created->IsNamed(level));
+  CHECK(!ObjMsgData::dataFactory.Create(2, "unregistered"));
+  CHECK(ObjMsgData::FindName("unregistered") == OBJMSG_NO_NAME);
+
+  // A full table returns OBJMSG_NO_NAME, and registration fails
+  for (int i = 0; i < OBJMSG_MAX_NAMES; i++)
+  {
+    ObjMsgData::InternName("name" + to_string(i));
+  }
+  CHECK(ObjMsgData::InternName("overflow") == OBJMSG_NO_NAME);
+  CHECK(ObjMsgData::nameRegistry.Name(OBJMSG_NO_NAME).empty());
+  CHECK(!ObjMsgData::RegisterClass(1, "overflow", ObjMsgDataInt::Create));
+  ObjMsgTransport transport(4);
+  CHECK(transport.Subscribe(1, "overflow", NULL) == OBJMSG_NO_TOPIC);
+
+  // Data that could not be named is never taken for another of its kind
+  ObjMsgDataRef first = ObjMsgDataInt::Create(1, "overflow", 1);
+  ObjMsgDataRef second = ObjMsgDataInt::Create(1, "overflow2", 2);
+  CHECK(first->GetNameId() == OBJMSG_NO_NAME && !first->IsNamed(second->GetNameId()));
+  CHECK(transport.Send(first, NORMAL_PRIORITY, true));
+  CHECK(transport.Send(second, NORMAL_PRIORITY, true));
+  ObjMsgDataRef received;
+  CHECK(transport.Receive(received, 0) && received == first);
+  CHECK(transport.Receive(received, 0) && received == second);
+}
+
+/// Classes are registered by (origin, name), and frozen only by Freeze()
+static void TestFactory()
+{
+  ObjMsgDataFactory factory;
+  CHECK(factory.RegisterClass(1, "level", ObjMsgDataInt::Create));
+  CHECK(factory.RegisterClass(2, "level", ObjMsgDataFloat::Create));
+  CHECK(!factory.RegisterClass(2, "level", ObjMsgDataInt::Create));
+
+  // Each origin gets its own class; other origins get the first registration
+  ObjMsgDataFactory::CreateFn floatCreate = ObjMsgDataFloat::Create;
+  CHECK(factory.Create(1, "level")->Is<ObjMsgDataInt>());
+  CHECK(factory.Create(2, "level")->Is<ObjMsgDataFloat>());
+  CHECK(factory.Create(9, "level")->Is<ObjMsgDataInt>());
+  CHECK(factory.Find(2, "level") == floatCreate && !factory.Find(1, "unknown"));
+
+  // A name remembered as unknown is found once registered
+  CHECK(!factory.Create(1, "late") && !factory.Create(1, "late"));
+  CHECK(factory.RegisterClass(3, "late", ObjMsgDataString::Create));
+  CHECK(factory.Create(1, "late")->Is<ObjMsgDataString>());
+
+  // Frozen, the index finds the same classes, and registration is closed
+  factory.Freeze();
+  CHECK(!factory.RegisterClass(4, "later", ObjMsgDataInt::Create));
+  CHECK(factory.Create(1, "level")->Is<ObjMsgDataInt>());
+  CHECK(factory.Create(2, "level")->Is<ObjMsgDataFloat>());
+  CHECK(factory.Create(9, "level")->Is<ObjMsgDataInt>());
+  CHECK(factory.Create(1, "late")->Is<ObjMsgDataString>());
+  CHECK(!factory.Create(1, "later") && !factory.Find(1, "unknown"));
+
+  // Freezing a transport leaves the data factory open for late registrants
+  ObjMsgTransport transport(4);
+  transport.Freeze();
+  CHECK(ObjMsgData::RegisterClass(5, "late", ObjMsgDataInt::Create));
+}
+
+/// Each data type has one descriptor, shared by its instances
+static void TestTypes()
+{
+  ObjMsgDataRef a = ObjMsgDataInt::Create(1, "level", 1);
+  ObjMsgDataRef b = ObjMsgDataInt::Create(2, "level", 2);
+  ObjMsgDataRef f = ObjMsgDataFloat::Create(1, "level", 1.5);
+  CHECK(&a->GetType() == &b->GetType() && &a->GetType() == &ObjMsgDataInt::Type());
+  CHECK(a->GetType().typeId != f->GetType().typeId);
+  CHECK(a->GetTag() == a->GetType().tag.c_str() && *a->GetTag());
+}
+
+/// A second class over int, which must not be taken for ObjMsgDataInt
+class LevelData : public ObjMsgDataT<int, LevelData>
+{
+public:
+  LevelData(uint16_t origin, char const* name) : ObjMsgDataT<int, LevelData>(origin, name) {}
+  bool DeserializeValue(cJSON* json) override { return false; }
+  bool GetValue(string& str) override { return false; }
+  bool GetValue(int& val) override { val = value; return true; }
+  bool GetValue(double& val) override { return false; }
+};
+
+/// Is<D>() and As<D>() check the data class, and ObjMsgTypeSwitch dispatches on it
+static void TestCasts()
+{
+  ObjMsgDataRef i = ObjMsgDataInt::Create(1, "level", 1);
+  ObjMsgDataRef f = ObjMsgDataFloat::Create(1, "level", 1.5);
+  ObjMsgDataRef l(new LevelData(1, "level"));
+  CHECK(i->Is<ObjMsgDataInt>() && i->As<ObjMsgDataInt>() == i.get());
+  CHECK(!f->Is<ObjMsgDataInt>() && f->As<ObjMsgDataInt>() == NULL);
+  CHECK(l->As<LevelData>() && !l->As<ObjMsgDataInt>() && !i->As<LevelData>());
+  CHECK(l->GetTypeId() != i->GetTypeId());
+
+  int ints = 0;
+  int others = 0;
+  ObjMsgTypeSwitch types;
+  CHECK(!types.Dispatch(i.get()));
+  types.On<ObjMsgDataInt>([&](ObjMsgDataInt* data) { int value; return data->GetValue(value) && (ints += value); });
+  CHECK(types.Dispatch(i.get()) && ints == 1);
+  CHECK(!types.Dispatch(f.get()));
+  types.Otherwise([&](ObjMsgData* data) { return ++others; });
+  CHECK(types.Dispatch(f.get()) && types.Dispatch(l.get()) && others == 2 && ints == 1);
+}
+
+/// Create() draws from the type's reserved blocks, then falls back to the heap
+static void TestBlockPool()
+{
+  ObjMsgPoolStats stats;
+  CHECK(ObjMsgDataFloat::ReservePool(2) && !ObjMsgDataFloat::ReservePool(4));
+  ObjMsgDataRef a = ObjMsgDataFloat::Create(1, "level", 1.0);
+  ObjMsgDataRef b = ObjMsgDataFloat::Create(1, "level", 2.0);
+  ObjMsgDataRef heap = ObjMsgDataFloat::Create(1, "level", 3.0);
+  ObjMsgDataFloat::GetPoolStats(stats);
+  CHECK(stats.capacity == 2 && stats.used == 2 && stats.allocated == 2 && stats.exhausted == 1);
+  CHECK(stats.blockSize >= sizeof(ObjMsgDataFloat));
+
+  // Released blocks are reused; heap objects are not returned to the pool
+  ObjMsgData *reused = a.get();
+  a.reset();
+  heap.reset();
+  a = ObjMsgDataFloat::Create(1, "level", 4.0);
+  CHECK(a.get() == reused);
+  double value;
+  CHECK(a->GetValue(value) && value == 4.0);
+  a.reset();
+  b.reset();
+  ObjMsgDataFloat::GetPoolStats(stats);
+  CHECK(stats.used == 0 && stats.highWater == 2 && stats.allocated == 3);
+}
+
+/// References count copies; moves and empty references do not
+static void TestRefs()
+{
+  ObjMsgPoolStats stats;
+  ObjMsgDataRef empty;
+  CHECK(!empty && empty.use_count() == 0 && !ObjMsgDataRef(nullptr));
+
+  ObjMsgDataRef a = ObjMsgDataFloat::Create(1, "level", 1.0);
+  CHECK(a && a.use_count() == 1);
+  ObjMsgDataRef b = a;
+  CHECK(b == a && a.use_count() == 2);
+  ObjMsgDataRef c = std::move(b);
+  CHECK(!b && c == a && a.use_count() == 2);
+  b = c;
+  b = b;
+  CHECK(a.use_count() == 3);
+  c.reset();
+  c.reset();
+  b = std::move(a);
+  CHECK(!a && !c && b.use_count() == 1);
+  ObjMsgDataFloat::GetPoolStats(stats);
+  CHECK(stats.used == 1);
+
+  // Releasing the last reference returns the block to the pool
+  b = empty;
+  ObjMsgDataFloat::GetPoolStats(stats);
+  CHECK(!b && stats.used == 0);
+}
+
+int main()
+{
+  TestBlockPool();
+  TestRefs();
+  TestTypes();
+  TestCasts();
+  TestFactory();
+  TestNames();
+  return 0;
+}
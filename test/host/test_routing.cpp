@@ -0,0 +1,133 @@
+/*
+ * ObjMsgTransport routing: forwards by origin, topic subscriptions and
+ * batches, before and after Freeze()
+ */
+#include "ObjMsg.h"
+#include "check.h"
+
+/// Counts what it consumes, by path
+class CountingHost : public ObjMsgHost
+{
+public:
+  int consumed = 0;
+  int batches = 0;
+  int topics = 0;
+  void *context = NULL;
+
+  CountingHost(ObjMsgTransport *transport, uint16_t origin)
+      : ObjMsgHost(transport, "COUNTING", origin) {}
+  bool Consume(ObjMsgData *data) override
+  {
+    ++consumed;
+    return true;
+  }
+  bool ConsumeTopic(ObjMsgData *data, void *context) override
+  {
+    ++topics;
+    this->context = context;
+    return true;
+  }
+  int ConsumeBatch(span<ObjMsgData *> batch) override
+  {
+    ++batches;
+    return ObjMsgHost::ConsumeBatch(batch);
+  }
+  bool Start() override { return true; }
+};
+
+/// Receive everything waiting on 'transport'
+static void Drain(ObjMsgTransport &transport)
+{
+  ObjMsgDataRef received;
+  while (transport.Receive(received, 0))
+  {
+  }
+}
+
+/// A subscriber is given its (origin, name) topic only, with its context
+static void TestSubscribe()
+{
+  ObjMsgTransport transport(8);
+  CountingHost host(&transport, 5);
+  int port;
+  uint16_t topic = transport.Subscribe(1, "led", &host, &port);
+  CHECK(transport.Send(ObjMsgDataInt::Create(1, "led", 1)));
+  CHECK(transport.Send(ObjMsgDataInt::Create(1, "other", 1)));
+  CHECK(transport.Send(ObjMsgDataInt::Create(2, "led", 1)));
+  Drain(transport);
+  CHECK(host.topics == 1 && host.consumed == 0 && host.context == &port);
+  CHECK(ObjMsgDataInt::Create(1, "led", 1)->GetTopic() == topic);
+}
+
+/// A host both forwarded an origin and subscribed to one of its topics
+/// consumes that data once, through ConsumeTopic(), singly and in batches
+static void TestSubscribedConsumer(bool freeze)
+{
+  ObjMsgTransport transport(8);
+  CountingHost both(&transport, 5);
+  CountingHost forwarded(&transport, 6);
+  transport.AddForward(0, &both);
+  transport.AddForward(0, &forwarded);
+  transport.AddForward(1, &forwarded);
+  transport.Subscribe(0, "a", &both);
+  if (freeze)
+  {
+    transport.Freeze();
+  }
+
+  CHECK(transport.Send(ObjMsgDataInt::Create(0, "a", 1)));
+  Drain(transport);
+  CHECK(both.topics == 1 && both.consumed == 0 && forwarded.consumed == 1);
+
+  for (int i = 0; i < 4; i++)
+  {
+    CHECK(transport.Send(ObjMsgDataInt::Create(i % 2, i < 2 ? "a" : "b", i)));
+  }
+  ObjMsgDataRef batch[4];
+  CHECK(transport.ReceiveBatch(batch, 0) == 4);
+  CHECK(both.topics == 2 && both.consumed == 1 && both.batches == 1);
+  CHECK(forwarded.consumed == 5 && forwarded.batches == 1);
+
+  // Batches over MSG_BATCH_MAX_DEPTH are forwarded in parts
+  ObjMsgDataRef big[MSG_BATCH_MAX_DEPTH + 4];
+  for (ObjMsgDataRef &dataRef : big)
+  {
+    dataRef = ObjMsgDataInt::Create(1, "c", 0);
+  }
+  transport.ForwardBatch(big);
+  CHECK(forwarded.consumed == 5 + MSG_BATCH_MAX_DEPTH + 4 && forwarded.batches == 3);
+}
+
+/// Frozen routing skips a consumer's own origin, and rejects changes
+static void TestFreeze()
+{
+  ObjMsgTransport transport(8);
+  CountingHost a(&transport, 5);
+  CountingHost b(&transport, 3);
+  transport.AddForward(3, &a);
+  transport.AddForward(3, &b);
+  transport.AddForward(1, &b);
+  transport.Subscribe(7, "x", &a);
+  transport.Freeze();
+  CHECK(!transport.AddForward(0, &a));
+  CHECK(transport.Subscribe(7, "y", &a) == OBJMSG_NO_TOPIC);
+
+  CHECK(transport.Send(ObjMsgDataInt::Create(3, "level", 1)));
+  CHECK(transport.Send(ObjMsgDataInt::Create(1, "level", 1)));
+  CHECK(transport.Send(ObjMsgDataInt::Create(7, "x", 1)));
+  CHECK(transport.Send(ObjMsgDataInt::Create(200, "x", 1)));
+  Drain(transport);
+  CHECK(a.consumed == 1 && a.topics == 1);
+  CHECK(b.consumed == 1 && b.topics == 0);
+  CHECK(transport.IsForwardedTo(ObjMsgDataInt::Create(3, "level", 1).get(), &a));
+  CHECK(!transport.IsForwardedTo(ObjMsgDataInt::Create(3, "level", 1).get(), &b));
+}
+
+int main()
+{
+  TestSubscribe();
+  TestSubscribedConsumer(false);
+  TestSubscribedConsumer(true);
+  TestFreeze();
+  return 0;
+}
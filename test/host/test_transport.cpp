@@ -0,0 +1,199 @@
+/*
+ * ObjMsgTransport slot ring: order, wrap around, full lanes and references;
+ * priority lanes, conflation, batches, overflow policies and ISR sends
+ */
+#include "ObjMsg.h"
+#include "check.h"
+
+/// Receives one message from 'arg' (an ObjMsgTransport) after a delay
+static void DelayedReceive(void *arg)
+{
+  ObjMsgDataRef received;
+  vTaskDelay(pdMS_TO_TICKS(10));
+  ((ObjMsgTransport *)arg)->Receive(received, 0);
+}
+
+/// Counts what it consumes, and the batches it arrives in
+class CountingHost : public ObjMsgHost
+{
+public:
+  int consumed = 0;
+  int batches = 0;
+
+  CountingHost(ObjMsgTransport *transport, uint16_t origin)
+      : ObjMsgHost(transport, "COUNTING", origin) {}
+  bool Consume(ObjMsgData *data) override
+  {
+    ++consumed;
+    return true;
+  }
+  int ConsumeBatch(span<ObjMsgData *> batch) override
+  {
+    ++batches;
+    return ObjMsgHost::ConsumeBatch(batch);
+  }
+  bool Start() override { return true; }
+};
+
+int main()
+{
+  const int depth = 4;
+  ObjMsgTransport transport(depth);
+  ObjMsgDataRef received;
+  int value;
+
+  // In order, across several wraps of the ring
+  for (int i = 0; i < depth * 3; i++)
+  {
+    CHECK(transport.Send(ObjMsgDataInt::Create(1, "level", i)));
+    CHECK(transport.Send(ObjMsgDataInt::Create(1, "level", 100 + i)));
+    CHECK(transport.Receive(received, 0) && received->GetValue(value) && value == i);
+    CHECK(transport.Receive(received, 0) && received->GetValue(value) && value == 100 + i);
+  }
+  CHECK(!transport.Receive(received, 0));
+
+  // A full lane rejects the newest message
+  for (int i = 0; i < depth; i++)
+  {
+    CHECK(transport.Send(ObjMsgDataInt::Create(1, "level", i)));
+  }
+  CHECK(!transport.Send(ObjMsgDataInt::Create(1, "level", depth)));
+  ObjMsgLaneStats stats;
+  transport.GetLaneStats(NORMAL_PRIORITY, stats);
+  CHECK(stats.dropped == 1 && stats.highWater == depth);
+  for (int i = 0; i < depth; i++)
+  {
+    CHECK(transport.Receive(received, 0) && received->GetValue(value) && value == i);
+  }
+
+  // The ring shares the sender's data, and releases it once received
+  ObjMsgDataRef data = ObjMsgDataInt::Create(1, "level", 7);
+  CHECK(transport.Send(data) && data.use_count() == 2);
+  CHECK(transport.Receive(received, 0) && received.get() == data.get());
+  received.reset();
+  CHECK(data.use_count() == 1);
+
+  // Strict priority: higher lanes drain first, whatever the send order
+  CHECK(transport.Send(ObjMsgDataInt::Create(1, "level", 3), LOW_PRIORITY));
+  CHECK(transport.Send(ObjMsgDataInt::Create(1, "level", 2)));
+  CHECK(transport.Send(ObjMsgDataInt::Create(1, "level", 1), HIGH_PRIORITY));
+  for (int i = 1; i <= 3; i++)
+  {
+    CHECK(transport.Receive(received, 0) && received->GetValue(value) && value == i);
+  }
+
+  // Weighted drain: up to 'weight' messages from each lane per round
+  ObjMsgTransport weighted(8, WEIGHTED_DRAIN);
+  weighted.ConfigureLane(HIGH_PRIORITY, 8, 2);
+  weighted.ConfigureLane(LOW_PRIORITY, 8, 1);
+  for (int i = 0; i < 6; i++)
+  {
+    CHECK(weighted.Send(ObjMsgDataInt::Create(1, "level", 0), HIGH_PRIORITY));
+    CHECK(weighted.Send(ObjMsgDataInt::Create(1, "level", 2), LOW_PRIORITY));
+  }
+  string order;
+  while (weighted.Receive(received, 0) && received->GetValue(value))
+  {
+    order += char('0' + value);
+  }
+  CHECK(order == "002002002222");
+  weighted.GetLaneStats(HIGH_PRIORITY, stats);
+  CHECK(stats.sent == 6 && stats.received == 6 && stats.dropped == 0);
+
+  // Conflatable data replaces waiting data with the same origin and name,
+  // but not waiting data sent unconflated
+  ObjMsgTransport conflating(2);
+  CHECK(conflating.Send(ObjMsgDataInt::Create(1, "stick", 0), NORMAL_PRIORITY, true));
+  CHECK(conflating.Send(ObjMsgDataInt::Create(1, "stick", 1)));
+  for (int i = 2; i < 6; i++)
+  {
+    CHECK(conflating.Send(ObjMsgDataInt::Create(1, "stick", i), NORMAL_PRIORITY, true));
+  }
+  CHECK(conflating.Receive(received, 0) && received->GetValue(value) && value == 5);
+  CHECK(conflating.Receive(received, 0) && received->GetValue(value) && value == 1);
+  CHECK(!conflating.Receive(received, 0));
+  conflating.GetLaneStats(NORMAL_PRIORITY, stats);
+  CHECK(stats.sent == 6 && stats.conflated == 4 && stats.dropped == 0);
+
+  // A batch drains up to its size, and each consumer gets one
+  // ConsumeBatch() with the members it would have got from Forward()
+  ObjMsgTransport batching(8);
+  CountingHost consumer(&batching, 5);
+  CountingHost producer(&batching, 0);
+  batching.AddForward(0, &consumer);
+  batching.AddForward(1, &consumer);
+  batching.AddForward(0, &producer);
+  for (int i = 0; i < 5; i++)
+  {
+    CHECK(batching.Send(ObjMsgDataInt::Create(i % 2, "level", i)));
+  }
+  ObjMsgDataRef batch[4];
+  CHECK(batching.ReceiveBatch(batch, 0) == 4);
+  CHECK(consumer.consumed == 4 && consumer.batches == 1);
+  CHECK(producer.consumed == 0);
+  CHECK(batching.ReceiveBatch(batch, 0) == 1 && batch[0]->GetValue(value) && value == 4);
+  CHECK(batching.ReceiveBatch(batch, 0) == 0);
+
+  // DROP_OLDEST evicts the sender's own oldest waiting message, or drops
+  // the send if it has none waiting
+  ObjMsgTransport evicting(3);
+  CHECK(evicting.Send(ObjMsgDataInt::Create(1, "edge", 1)));
+  for (int i = 0; i < 3; i++)
+  {
+    CHECK(evicting.Send(ObjMsgDataInt::Create(2, "adc", i), NORMAL_PRIORITY, false, DROP_OLDEST));
+  }
+  CHECK(!evicting.Send(ObjMsgDataInt::Create(3, "other", 0), NORMAL_PRIORITY, false, DROP_OLDEST));
+  CHECK(evicting.Receive(received, 0) && received->IsFrom(1));
+  CHECK(evicting.Receive(received, 0) && received->GetValue(value) && value == 1);
+  CHECK(evicting.Receive(received, 0) && received->GetValue(value) && value == 2);
+  CHECK(!evicting.Receive(received, 0));
+  evicting.GetLaneStats(NORMAL_PRIORITY, stats);
+  CHECK(stats.evicted == 1 && stats.dropped == 1);
+
+  // SPILL_OVERFLOW takes the lane's extra slots, in order
+  ObjMsgTransport spilling(2);
+  spilling.ConfigureLane(NORMAL_PRIORITY, 2, 1, 2);
+  for (int i = 0; i < 2; i++)
+  {
+    CHECK(spilling.Send(ObjMsgDataInt::Create(1, "level", i)));
+  }
+  CHECK(!spilling.Send(ObjMsgDataInt::Create(1, "level", 9)));
+  CHECK(spilling.Send(ObjMsgDataInt::Create(1, "level", 2), NORMAL_PRIORITY, false, SPILL_OVERFLOW));
+  CHECK(spilling.Send(ObjMsgDataInt::Create(1, "level", 3), NORMAL_PRIORITY, false, SPILL_OVERFLOW));
+  CHECK(!spilling.Send(ObjMsgDataInt::Create(1, "level", 4), NORMAL_PRIORITY, false, SPILL_OVERFLOW));
+  for (int i = 0; i < 4; i++)
+  {
+    CHECK(spilling.Receive(received, 0) && received->GetValue(value) && value == i);
+  }
+  spilling.GetLaneStats(NORMAL_PRIORITY, stats);
+  CHECK(stats.spilled == 2 && stats.dropped == 2);
+
+  // BLOCK_OVERFLOW waits for space, up to the block time
+  ObjMsgTransport blocking(1);
+  blocking.SetOverflow(BLOCK_OVERFLOW, 50);
+  CHECK(blocking.Send(ObjMsgDataInt::Create(1, "level", 0)));
+  CHECK(!blocking.Send(ObjMsgDataInt::Create(1, "level", 1)));
+  xTaskCreate(DelayedReceive, "receive", 4096, &blocking, 5, NULL);
+  CHECK(blocking.Send(ObjMsgDataInt::Create(1, "level", 2)));
+  blocking.GetLaneStats(NORMAL_PRIORITY, stats);
+  CHECK(stats.blocked == 2 && stats.timeouts == 1);
+
+  // SendFromISR() shares pooled data; a pool object is free once received
+  ObjMsgTransport isr(1);
+  ObjMsgDataPool<ObjMsgDataInt> pool(1, "edge", 2, 0);
+  BaseType_t woken = pdFALSE;
+  const ObjMsgDataRef *point = pool.Take();
+  static_cast<ObjMsgDataInt *>(point->get())->SetRawValue(7);
+  CHECK(isr.SendFromISR(*point, NORMAL_PRIORITY, DROP_NEWEST, &woken));
+  const ObjMsgDataRef *other = pool.Take();
+  CHECK(other && other != point);
+  CHECK(!isr.SendFromISR(*other, NORMAL_PRIORITY, DROP_NEWEST, &woken));
+  // Lanes have MSG_SPILL_DEPTH overflow slots by default
+  CHECK(isr.SendFromISR(*other, NORMAL_PRIORITY, SPILL_OVERFLOW, &woken));
+  CHECK(!pool.Take() && pool.Exhausted() == 1);
+  CHECK(isr.Receive(received, 0) && received.get() == point->get());
+  CHECK(received->GetValue(value) && value == 7);
+  received.reset();
+  CHECK(pool.Take() == point);
+  return 0;
+}
@@ -0,0 +1,389 @@
+/*
+ * WebsocketHost client subscriptions, receiving (message size, fragmentation,
+ * batches, oversize messages), batching, shared frame buffers, send queues
+ * and the batching window
+ *
+ * Clients and frames are simulated by the stub esp_http_server: a test
+ * "receives" a frame by setting stub_recv and calling the /ws handler, and
+ * runs the httpd work queued for sending with stub_run_work().
+ */
+#include "WebsocketHost.h"
+#include "check.h"
+#include <lwip/sockets.h>
+
+/// Exposes the handlers the httpd task calls
+class TestWebsocketHost : public WebsocketHost
+{
+public:
+  TestWebsocketHost(ObjMsgTransport *transport, uint16_t origin) : WebsocketHost(transport, origin) {}
+
+  using WebsocketHost::Drain;
+  using WebsocketHost::StartWebserver;
+  using WebsocketHost::Subscribe;
+  using WebsocketHost::WebSockMsgHandler;
+};
+
+static ObjMsgTransport transport(8);
+// The hosts' tasks run for the life of the process
+static TestWebsocketHost receiving(&transport, 6);
+static TestWebsocketHost batching(&transport, 5);
+
+/// Connect websocket client 'fd' to 'host'
+/// @param reconnect: 'fd' is already a stub client, handshaking again
+static void Open(TestWebsocketHost &host, int fd, bool reconnect = false)
+{
+  if (!reconnect)
+  {
+    stub_clients.push_back({fd, true, {}, {}, ESP_OK});
+  }
+  httpd_req_t req = {};
+  req.method = HTTP_GET;
+  req.user_ctx = &host;
+  req.fd = fd;
+  TestWebsocketHost::WebSockMsgHandler(&req);
+}
+
+/// Have 'host' receive 'payload' from client 'fd', as one frame
+static esp_err_t Frame(TestWebsocketHost &host, int fd, const string &payload,
+                       httpd_ws_type_t type = HTTPD_WS_TYPE_TEXT, bool final = true)
+{
+  httpd_req_t req = {};
+  req.method = HTTP_POST;
+  req.user_ctx = &host;
+  req.fd = fd;
+  stub_recv = payload;
+  stub_recv_type = type;
+  stub_recv_final = final;
+  return TestWebsocketHost::WebSockMsgHandler(&req);
+}
+
+/// Get the next data produced from a received message, as "name=value"
+static string Produced()
+{
+  ObjMsgDataRef data;
+  if (!transport.Receive(data, 200))
+  {
+    return "";
+  }
+  string value;
+  data->GetValue(value);
+  return string(data->GetName()) + "=" + value;
+}
+
+/// Find the client state 'host' keeps for 'fd'
+static ws_client_t Client(TestWebsocketHost &host, int fd)
+{
+  for (ws_client_t &client : host.GetClients())
+  {
+    if (client.fd == fd)
+    {
+      return client;
+    }
+  }
+  ws_client_t none = {};
+  none.fd = -1;
+  return none;
+}
+
+/// Have 'host' broadcast 'a' and 'b', recording only these frames per client
+static void Broadcast(TestWebsocketHost &host, ObjMsgData *a, ObjMsgData *b)
+{
+  for (StubWsClient &client : stub_clients)
+  {
+    client.frames.clear();
+  }
+  ObjMsgData *batch[] = {a, b};
+  CHECK(host.ConsumeBatch(batch) == 2);
+  CHECK(stub_run_work() == 1);
+}
+
+static void TestSubscribe()
+{
+  TestWebsocketHost host(&transport, 4);
+  host.StartWebserver();
+  Open(host, 60);
+  Open(host, 61);
+  ObjMsgDataRef a = ObjMsgDataInt::Create(3, "a", 1);
+  ObjMsgDataRef b = ObjMsgDataInt::Create(1, "b", 2);
+
+  // New clients receive everything
+  Broadcast(host, a.get(), b.get());
+  CHECK(stub_clients[0].frames.size() == 2 && stub_clients[1].frames.size() == 2);
+  CHECK(Client(host, 60).all && Client(host, 60).sent == 2);
+
+  // A subscription filters by origin or name
+  CHECK(host.Subscribe(60, "{\"origins\":[3]}"));
+  CHECK(host.Subscribe(61, "{\"names\":[\"b\",\"zz\"]}"));
+  Broadcast(host, a.get(), b.get());
+  CHECK(stub_clients[0].frames.size() == 1 && stub_clients[0].frames[0].find("\"a\"") != string::npos);
+  CHECK(stub_clients[1].frames.size() == 1 && stub_clients[1].frames[0].find("\"b\"") != string::npos);
+  ws_client_t client = Client(host, 61);
+  CHECK(!client.all && client.nameCount == 1 && client.originCount == 0 && client.sent == 3);
+
+  // Client names are looked up, never interned
+  CHECK(ObjMsgData::FindName("zz") == OBJMSG_NO_NAME);
+
+  // Malformed subscriptions, and origins outside 0..65535, change nothing
+  CHECK(!host.Subscribe(60, "{\"origins\":[70000]}"));
+  CHECK(!host.Subscribe(60, "{\"origins\":[-1]}"));
+  CHECK(!host.Subscribe(60, "{\"origins\":[1,"));
+  CHECK(!host.Subscribe(60, "\"some\""));
+  client = Client(host, 60);
+  CHECK(client.originCount == 1 && client.origins[0] == 3);
+  CHECK(host.Subscribe(60, "{\"origins\":[65535]}"));
+  client = Client(host, 60);
+  CHECK(client.originCount == 1 && client.origins[0] == 65535);
+
+  // "*" restores everything; so does a new handshake on the socket
+  CHECK(host.Subscribe(60, "\"*\""));
+  Open(host, 61, true);
+  Broadcast(host, a.get(), b.get());
+  CHECK(stub_clients[0].frames.size() == 2 && stub_clients[1].frames.size() == 2);
+  CHECK(Client(host, 61).sent == 2);
+
+  // Closed clients are forgotten on the next broadcast
+  stub_clients.erase(stub_clients.begin());
+  Broadcast(host, a.get(), b.get());
+  CHECK(host.GetClients().size() == 1 && Client(host, 60).fd == -1);
+  stub_clients.clear();
+}
+
+/// Messages of any size, whole or fragmented, alone or batched, are parsed
+/// and produced by the receive task
+static void TestReceive()
+{
+  TestWebsocketHost &host = receiving;
+  CHECK(host.Start());
+  host.StartWebserver();
+  ObjMsgData::RegisterClass(6, "text", ObjMsgDataString::Create);
+  ObjMsgData::RegisterClass(6, "n", ObjMsgDataInt::Create);
+  Open(host, 70);
+
+  // Larger than a single small buffer
+  string large(1000, 'x');
+  CHECK(Frame(host, 70, "{\"name\":\"text\",\"value\":\"" + large + "\"}") == ESP_OK);
+  CHECK(Produced() == "text=" + large);
+
+  // Reassembled from fragments
+  CHECK(Frame(host, 70, "{\"name\":\"te", HTTPD_WS_TYPE_TEXT, false) == ESP_OK);
+  CHECK(Frame(host, 70, "xt\",\"value\":\"ab", HTTPD_WS_TYPE_CONTINUE, false) == ESP_OK);
+  CHECK(Frame(host, 70, "c\"}", HTTPD_WS_TYPE_CONTINUE, true) == ESP_OK);
+  CHECK(Produced() == "text=abc");
+
+  // A continuation without a start, and binary frames, are ignored
+  CHECK(Frame(host, 70, "{\"name\":\"n\",\"value\":1}", HTTPD_WS_TYPE_CONTINUE, true) == ESP_OK);
+  CHECK(Frame(host, 70, "{\"name\":\"n\",\"value\":1}", HTTPD_WS_TYPE_BINARY) == ESP_OK);
+  CHECK(Produced() == "");
+
+  // A batch, including a subscription, in order; the subscription is
+  // consumed, not produced
+  CHECK(Frame(host, 70, " [{\"name\":\"n\",\"value\":5},"
+                        "{\"name\":\"__WS_SUBSCRIBE__\",\"value\":{\"origins\":[3]}},"
+                        "{\"name\":\"text\",\"value\":\"y\"}]") == ESP_OK);
+  CHECK(Produced() == "n=5");
+  CHECK(Produced() == "text=y");
+  CHECK(Produced() == "");
+  ws_client_t client = Client(host, 70);
+  CHECK(!client.all && client.originCount == 1 && client.origins[0] == 3);
+
+  // Too large closes the connection, whole or reassembled
+  CHECK(Frame(host, 70, string(WS_RECV_MAX + 1, ' ')) == ESP_FAIL);
+  CHECK(Frame(host, 70, string(WS_RECV_MAX / 2 + 1, ' '), HTTPD_WS_TYPE_TEXT, false) == ESP_OK);
+  CHECK(Frame(host, 70, string(WS_RECV_MAX / 2, ' '), HTTPD_WS_TYPE_CONTINUE, true) == ESP_FAIL);
+  stub_clients.clear();
+}
+
+/// Batched data is conflated per origin and name, and sent as one frame per client
+static void TestBatching()
+{
+  TestWebsocketHost host(&transport, 4);
+  host.SetBatching(1000, 100);
+  host.StartWebserver();
+  Open(host, 62);
+  Open(host, 63);
+  CHECK(host.Subscribe(63, "{\"origins\":[1]}"));
+  ObjMsgDataRef a1 = ObjMsgDataInt::Create(3, "a", 1);
+  ObjMsgDataRef b = ObjMsgDataInt::Create(3, "b", 2);
+  ObjMsgDataRef a2 = ObjMsgDataInt::Create(3, "a", 3);
+  ObjMsgDataRef unnamed1 = ObjMsgDataInt::Create(3, OBJMSG_NO_NAME, 4);
+  ObjMsgDataRef unnamed2 = ObjMsgDataInt::Create(3, OBJMSG_NO_NAME, 5);
+  ObjMsgDataRef over = ObjMsgDataString::Create(1, "over", string(80, 'x').c_str());
+
+  // Under budget, nothing is sent until the window ends
+  ObjMsgData *batch[] = {a1.get(), b.get(), a2.get(), unnamed1.get(), unnamed2.get()};
+  CHECK(host.ConsumeBatch(batch) == 5);
+  CHECK(stub_run_work() == 0);
+
+  // Over budget, sent at once; 'a' keeps its place, and unnamed data is not
+  // taken for other unnamed data
+  CHECK(host.Consume(over.get()));
+  CHECK(stub_run_work() == 1);
+  CHECK(stub_clients[0].frames.size() == 1 && stub_clients[0].types[0] == HTTPD_WS_TYPE_TEXT);
+  string expected = "[{\"name\":\"a\",\"value\":3},{\"name\":\"b\",\"value\":2},"
+                    "{\"name\":\"\",\"value\":4},{\"name\":\"\",\"value\":5},"
+                    "{\"name\":\"over\",\"value\":\"" + string(80, 'x') + "\"}]";
+  CHECK(stub_clients[0].frames[0] == expected);
+  CHECK(stub_clients[1].frames.size() == 1 && stub_clients[1].frames[0].find("\"a\"") == string::npos);
+
+  // MessagePack frames are binary, an array of the clients' data
+  host.SetBatching(1000, 1, BINARY_FORMAT);
+  CHECK(host.Consume(b.get()));
+  CHECK(stub_run_work() == 1);
+  CHECK(stub_clients[0].frames.size() == 2 && stub_clients[0].types[1] == HTTPD_WS_TYPE_BINARY);
+  CHECK((uint8_t)stub_clients[0].frames[1][0] == 0x91 && stub_clients[1].frames.size() == 1);
+  stub_clients.clear();
+}
+
+/// Broadcasts hold the shared encodings until sent, and a batch frame is built
+/// once, in a pooled buffer, for the clients that receive all of the batch
+static void TestSharedFrames()
+{
+  TestWebsocketHost host(&transport, 4);
+  host.StartWebserver();
+  Open(host, 65);
+  Open(host, 66);
+  Open(host, 67);
+  CHECK(host.Subscribe(67, "{\"names\":[\"b\"]}"));
+  ObjMsgDataRef a = ObjMsgDataInt::Create(3, "a", 1);
+  ObjMsgDataRef b = ObjMsgDataInt::Create(3, "b", 2);
+  ObjMsgBufferRef encoded = a->Encode(JSON_FORMAT);
+  long refs = encoded.use_count();
+
+  // Unbatched, the work refers to the cached encoding, and releases it once sent
+  CHECK(host.Consume(a.get()));
+  CHECK(encoded.use_count() == refs + 1 && a->Encode(JSON_FORMAT) == encoded);
+  CHECK(stub_run_work() == 1);
+  CHECK(encoded.use_count() == refs);
+  CHECK(stub_clients[0].frames.back() == encoded->c_str());
+
+  // Batched, clients 65 and 66 share a frame; 67 gets its own
+  ObjMsgPoolStats stats;
+  CHECK(ObjMsgBuffer::ReservePool(4, 64));
+  ObjMsgBuffer::GetPoolStats(stats);
+  uint32_t allocated = stats.allocated;
+  host.SetBatching(1000, 1);
+  ObjMsgData *batch[] = {a.get(), b.get()};
+  CHECK(host.ConsumeBatch(batch) == 2);
+  CHECK(stub_run_work() == 1);
+  ObjMsgBuffer::GetPoolStats(stats);
+  CHECK(stats.allocated == allocated + 3 && stats.used == 1 && stats.exhausted == 0);
+  CHECK(stub_clients[0].frames.back() == stub_clients[1].frames.back());
+  CHECK(stub_clients[2].frames.back() == "[{\"name\":\"b\",\"value\":2}]");
+  CHECK(encoded.use_count() == refs);
+
+  // Work items are reused, with their capacity
+  CHECK(host.ConsumeBatch(batch) == 2);
+  CHECK(stub_run_work() == 1);
+  ObjMsgBuffer::GetPoolStats(stats);
+  CHECK(stats.allocated == allocated + 5 && stats.used == 1);
+  stub_clients.clear();
+}
+
+/// Have 'host' broadcast 'data', as one work item
+static void Send(TestWebsocketHost &host, ObjMsgDataRef &data)
+{
+  CHECK(host.Consume(data.get()));
+  CHECK(stub_run_work() == 1);
+}
+
+/// A client whose socket is full queues its frames, conflating or dropping
+/// them, without holding up the others; it is closed if it never recovers
+static void TestSendQueues()
+{
+  TestWebsocketHost host(&transport, 4);
+  host.SetSendQueue(2, CONFLATE_POLICY, 3);
+  host.StartWebserver();
+  Open(host, 68);
+  Open(host, 69);
+  ObjMsgDataRef a1 = ObjMsgDataInt::Create(3, "a", 1);
+  ObjMsgDataRef b = ObjMsgDataInt::Create(3, "b", 2);
+  ObjMsgDataRef a2 = ObjMsgDataInt::Create(3, "a", 3);
+  ObjMsgDataRef unnamed1 = ObjMsgDataInt::Create(3, OBJMSG_NO_NAME, 4);
+  ObjMsgDataRef unnamed2 = ObjMsgDataInt::Create(3, OBJMSG_NO_NAME, 5);
+
+  // The newer 'a' replaces the queued one
+  stub_unwritable.insert(69);
+  Send(host, a1);
+  Send(host, b);
+  Send(host, a2);
+  ws_client_t client = Client(host, 69);
+  CHECK(client.depth == 2 && client.highWater == 2 && client.conflated == 1 && client.sent == 0);
+  CHECK(stub_clients[0].frames.size() == 3 && stub_clients[1].frames.empty());
+
+  // Unnamed data is never conflated; the full queue drops its oldest frames
+  Send(host, unnamed1);
+  Send(host, unnamed2);
+  client = Client(host, 69);
+  CHECK(client.depth == 2 && client.dropped == 2 && client.conflated == 1);
+
+  // Writable again, the queue drains in order
+  stub_unwritable.erase(69);
+  host.Drain();
+  client = Client(host, 69);
+  CHECK(client.depth == 0 && client.sent == 2 && client.failed == 0);
+  CHECK(stub_clients[1].frames.size() == 2 && stub_clients[1].frames[0] == unnamed1->Encode(JSON_FORMAT)->c_str());
+  CHECK(stub_clients[1].frames[1] == unnamed2->Encode(JSON_FORMAT)->c_str());
+  CHECK(Client(host, 68).sent == 5 && Client(host, 68).highWater == 1);
+
+  // Dropping 'disconnectDrops' frames, with none sent, closes the client
+  stub_unwritable.insert(69);
+  Send(host, a1);
+  Send(host, b);
+  Send(host, unnamed1);
+  Send(host, unnamed2);
+  CHECK(Client(host, 69).dropped == 4 && stub_clients.size() == 2);
+  Send(host, a2);
+  CHECK(stub_clients.size() == 1 && stub_clients[0].fd == 68);
+  Send(host, a1);
+  CHECK(Client(host, 69).fd == -1 && Client(host, 68).sent == 11);
+  stub_unwritable.clear();
+  stub_clients.clear();
+}
+
+/// A window ends 'windowMs' after its first data, and sending early, over
+/// budget, does not start another
+static void TestBatchWindow()
+{
+  TestWebsocketHost &host = batching;
+  host.SetBatching(200, 100);
+  CHECK(host.Start());
+  host.StartWebserver();
+  Open(host, 64);
+  ObjMsgDataRef a = ObjMsgDataInt::Create(3, "a", 1);
+  ObjMsgDataRef b = ObjMsgDataInt::Create(3, "b", 2);
+  ObjMsgDataRef c = ObjMsgDataInt::Create(3, "c", 3);
+  string large(120, 'x');
+  ObjMsgDataRef over = ObjMsgDataString::Create(1, "over", large.c_str());
+
+  // t=0: 'a' opens a window; t=40: over budget, sent early
+  host.Consume(a.get());
+  vTaskDelay(40);
+  host.Consume(over.get());
+  CHECK(stub_run_work() == 1);
+  // t=80: 'b' joins the same window, sent when it ends at t=200
+  vTaskDelay(40);
+  host.Consume(b.get());
+  vTaskDelay(200);
+  CHECK(stub_run_work() == 1);
+  CHECK(stub_clients[0].frames.back().find("\"b\"") != string::npos);
+  // t=360: 'c' opens a new, full window; a second give for the first
+  // window would have ended it early
+  vTaskDelay(80);
+  host.Consume(c.get());
+  vTaskDelay(120);
+  CHECK(stub_run_work() == 0);
+  vTaskDelay(160);
+  CHECK(stub_run_work() == 1);
+  stub_clients.clear();
+}
+
+int main()
+{
+  TestSubscribe();
+  TestReceive();
+  TestBatching();
+  TestSharedFrames();
+  TestSendQueues();
+  TestBatchWindow();
+  return 0;
+}